@@ -0,0 +1,27 @@
+# Copyright: 2026 Universal Ctags team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+CACHEDIR=$BUILDDIR/cache-dir.tmp
+
+rm -rf $CACHEDIR
+mkdir $CACHEDIR
+
+echo '#' first run
+${CTAGS} --quiet --options=NONE --cache-dir=$CACHEDIR -o - input.c
+ls $CACHEDIR | wc -l | tr -d ' '
+
+echo '#' second run
+${CTAGS} --quiet --options=NONE -V --cache-dir=$CACHEDIR -o - input.c 2>&1 \
+	| grep -e '^reuse cached tags' -e '^[^	 ][^	]*	'
+
+echo '#' different options
+${CTAGS} --quiet --options=NONE --cache-dir=$CACHEDIR --fields=+n -o - input.c
+ls $CACHEDIR | wc -l | tr -d ' '
+
+echo '#' no directory
+${CTAGS} --quiet --options=NONE --cache-dir=$CACHEDIR/none -o - input.c 2>&1 \
+	| sed -e 's|'$CACHEDIR'|CACHEDIR|'
+
+rm -rf $CACHEDIR
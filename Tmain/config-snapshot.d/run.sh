@@ -0,0 +1,43 @@
+# Copyright: 2026 Universal Ctags team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+SNAPSHOT=$BUILDDIR/config-snapshot.tmp
+
+. ../utils.sh
+
+exit_if_win32 "$CTAGS"
+
+export HOME=./myhome
+unset XDG_CONFIG_HOME
+rm -f $SNAPSHOT
+
+echo '#' recording
+${CTAGS} --_config-snapshot=$SNAPSHOT --quiet -o - input.foo
+grep -c '^O	' $SNAPSHOT
+
+echo '#' loading
+${CTAGS} --_config-snapshot=$SNAPSHOT --quiet -V -o - input.foo 2>&1 \
+	| grep -e '^Config snapshot' -e '^[a-z]*	input.foo' \
+	| sed -e 's|'$SNAPSHOT'|SNAPSHOT|'
+
+echo '#' ignored
+${CTAGS} --quiet --fields=+n --_config-snapshot=$SNAPSHOT -o - input.foo 2>&1
+
+echo '#' changed in the same second
+HOME=$BUILDDIR/myhome
+rm -rf $HOME
+mkdir -p $HOME/.ctags.d
+cp myhome/.ctags.d/foo.ctags $HOME/.ctags.d
+touch -d '2020-01-01 00:00:00.1' $HOME/.ctags.d/foo.ctags
+rm -f $SNAPSHOT
+${CTAGS} --_config-snapshot=$SNAPSHOT --quiet -o /dev/null input.foo
+sed -e 's/def/fed/' myhome/.ctags.d/foo.ctags > $HOME/.ctags.d/foo.ctags
+touch -d '2020-01-01 00:00:00.2' $HOME/.ctags.d/foo.ctags
+${CTAGS} --_config-snapshot=$SNAPSHOT --quiet -V -o - input.foo 2>&1 \
+	| grep -e '^Config snapshot' -e '^[a-z]*	input.foo' \
+	| sed -e 's|'$SNAPSHOT'|SNAPSHOT|' -e 's|'$HOME'|HOME|'
+rm -rf $HOME
+
+rm -f $SNAPSHOT
@@ -0,0 +1 @@
+function f0(a){return a+0};function f1(a){return a+1};function f2(a){return a+2};function f3(a){return a+3};function f4(a){return a+4};function f5(a){return a+5};function f6(a){return a+6};function f7(a){return a+7};function f8(a){return a+8};function f9(a){return a+9};function f10(a){return a+10};function f11(a){return a+11};function f12(a){return a+12};function f13(a){return a+13};function f14(a){return a+14};function f15(a){return a+15};function f16(a){return a+16};function f17(a){return a+17};function f18(a){return a+18};function f19(a){return a+19};function f20(a){return a+20};function f21(a){return a+21};function f22(a){return a+22};function f23(a){return a+23};function f24(a){return a+24};function f25(a){return a+25};function f26(a){return a+26};function f27(a){return a+27};function f28(a){return a+28};function f29(a){return a+29};function f30(a){return a+30};function f31(a){return a+31};function f32(a){return a+32};function f33(a){return a+33};function f34(a){return a+34};function f35(a){return a+35};function f36(a){return a+36};function f37(a){return a+37};function f38(a){return a+38};function f39(a){return a+39};function f40(a){return a+40};function f41(a){return a+41};function f42(a){return a+42};function f43(a){return a+43};function f44(a){return a+44};function f45(a){return a+45};function f46(a){return a+46};function f47(a){return a+47};function f48(a){return a+48};function f49(a){return a+49};function f50(a){return a+50};function f51(a){return a+51};function f52(a){return a+52};function f53(a){return a+53};function f54(a){return a+54};function f55(a){return a+55};function f56(a){return a+56};function f57(a){return a+57};function f58(a){return a+58};function f59(a){return a+59}
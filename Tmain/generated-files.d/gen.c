@@ -0,0 +1,2 @@
+/* @generated by gen.py */
+int gen_a;
@@ -0,0 +1,15 @@
+#!/bin/sh
+
+# Copyright: 2026 Universal Ctags team
+# License: GPL-2
+
+CTAGS=$1
+
+. ../utils.sh
+
+for policy in parse fast skip; do
+	echo '#' $policy
+	${CTAGS} --quiet --options=NONE --sort=yes --generated-files=$policy \
+			 -o - bundle.min.js gen.c package-lock.json plain.c \
+		| cut -f 1-3 | grep -v '^f[1-9]'
+done
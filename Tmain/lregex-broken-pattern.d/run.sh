@@ -0,0 +1,46 @@
+# Copyright: 2026 Universal Ctags team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+
+# The message of regerror () depends on the C library.
+filter ()
+{
+	sed -e 's/^\(ctags: Warning: regcomp [^:]*\):.*/\1: .../'
+}
+
+# A broken pattern given on the command line is reported when the
+# option is processed, and its kind is not defined.
+
+echo '# single line'
+${CTAGS} --quiet --options=NONE --with-list-header=no \
+	 --langdef=IdealLang --regex-IdealLang='/def ([a-z/\1/d,definition,definitions/' \
+	 --list-kinds-full=IdealLang 2>&1 | filter
+
+echo '# multi line'
+${CTAGS} --quiet --options=NONE --with-list-header=no \
+	 --langdef=IdealLang --mline-regex-IdealLang='/def ([a-z/\1/d,definition,definitions/{mgroup=1}' \
+	 --list-kinds-full=IdealLang 2>&1 | filter
+
+echo '# reusing the letter of a builtin kind'
+${CTAGS} --quiet --options=NONE --with-list-header=no \
+	 --regex-C='/[a/\1/x,xkind/' \
+	 --list-kinds-full=C 2>&1 | grep -e xkind -e regcomp -e "kind letter" | filter
+
+# The patterns in preloaded option files are compiled on first use;
+# nothing is compiled for listing kinds.
+echo '# preloaded'
+export HOME=$BUILDDIR/myhome
+unset XDG_CONFIG_HOME
+rm -rf $HOME
+mkdir -p $HOME/.ctags.d
+cat > $HOME/.ctags.d/ideal.ctags <<EOF2
+--langdef=IdealLang
+--map-IdealLang=+.ideal
+--regex-IdealLang=/def ([a-z/\1/d,definition,definitions/
+EOF2
+${CTAGS} --quiet --with-list-header=no --list-kinds-full=IdealLang 2>&1 | filter
+echo 'def abc' > $BUILDDIR/input.ideal
+${CTAGS} --quiet -o - $BUILDDIR/input.ideal 2>&1 | filter
+rm -rf $HOME $BUILDDIR/input.ideal
@@ -0,0 +1,29 @@
+#!/bin/sh
+
+# Copyright: 2026 Universal Ctags team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+TAGS=$BUILDDIR/max-limits.tags
+
+. ../utils.sh
+
+run_ctags ()
+{
+	echo '#' "$@"
+	${CTAGS} --quiet --options=NONE --extras=+f --fields=-T "$@" -o $TAGS many.c few.c 2>&1
+	grep -v '^!_' $TAGS
+}
+
+run_ctags --max-tags-per-file=0
+run_ctags --max-tags-per-file=5
+run_ctags --max-tags-per-file=4
+run_ctags --max-file-size=10
+run_ctags --max-file-size=0 --max-parse-time=60
+
+echo '#' invalid
+${CTAGS} --quiet --options=NONE --max-tags-per-file=x many.c 2>&1 \
+	| sed -e 's|^.*ctags:|ctags:|'
+
+rm -f $TAGS
@@ -0,0 +1,27 @@
+struct S {
+int a;
+int b;
+};
+
+/*
+
+int fake1;
+*/
+
+int f (void)
+{
+	return 0;
+}
+
+#if 0
+
+int fake2;
+#else
+
+int g;
+#endif
+
+#define M { \
+int fake3; \
+}
+int h;
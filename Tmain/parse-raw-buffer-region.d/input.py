@@ -0,0 +1,20 @@
+import os
+
+def f():
+    pass
+
+doc = """
+def fake():
+    pass
+"""
+
+@decorator
+def g():
+    pass
+
+class C:
+    def m(self):
+        pass
+
+def h():
+    pass
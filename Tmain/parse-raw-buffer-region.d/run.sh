@@ -0,0 +1,43 @@
+#!/bin/sh
+
+# Copyright: 2026 Universal Ctags team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+MINI_GEANY=$(dirname "${CTAGS}")/mini-geany
+
+. ../utils.sh
+
+if ! [ -x "${MINI_GEANY}" ]; then
+	skip "no mini-geany"
+fi
+
+reparse ()
+{
+	${MINI_GEANY} --reparse "$@" | sed -n -e '/^Reparsing/,$p'
+}
+
+# The tags of a reparsed region must have the extras of the tags made
+# by parsing the whole input; they are not of a guest parser.
+${MINI_GEANY} input.c | sed -n -e '/^Parsing/,$p'
+
+# in a struct
+reparse C 3 3 input.c
+# in a comment
+reparse C 8 8 input.c
+reparse C 11 11 input.c
+# in a skipped branch of #if 0, and in the branch taken
+reparse C 18 18 input.c
+reparse C 21 21 input.c
+# after braces in a macro
+reparse C 27 27 input.c
+
+reparse Python 3 3 input.py
+# in a triple quoted string
+reparse Python 7 7 input.py
+# a decorated function
+reparse Python 13 13 input.py
+# in a class
+reparse Python 17 17 input.py
+reparse Python 19 19 input.py
@@ -0,0 +1,38 @@
+#!/bin/sh
+
+# Copyright: 2026 Universal Ctags team
+# License: GPL-2
+
+READTAGS=$3
+
+. ../utils.sh
+
+#V="valgrind --leak-check=full -v"
+V=
+
+if ! [ -x "${READTAGS}" ]; then
+	skip "no readtags"
+fi
+
+if ! ( "${READTAGS}" -h | grep -q -e --limit ); then
+	skip "no limit option in readtags"
+fi
+
+echo '!_LIMIT' &&
+${V} ${READTAGS} -t output.tags -ne --limit 3 -l &&
+
+echo '!_LIMIT with filter' &&
+${V} ${READTAGS} -t output.tags -ne --limit 2 -Q '(eq? $kind "member")' -l &&
+
+echo '!_LIMIT larger than the number of tags' &&
+${V} ${READTAGS} -t output.tags --limit 100 - area &&
+
+if ! ( "${READTAGS}" -h | grep -q -e -S ); then
+	exit 0
+fi
+
+echo '!_LIMIT with sorter' &&
+${V} ${READTAGS} -t output.tags -ne --limit 4 -S '(<or> (<> $input &input) (<> $line &line) (<> $name &name))' -l &&
+
+echo '!_LIMIT with sorter keeping the input order of equal tags' &&
+${V} ${READTAGS} -t output.tags -ne --limit 5 -S '(<> $kind &kind)' -l
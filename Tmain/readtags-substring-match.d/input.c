@@ -0,0 +1,6 @@
+struct ring_buffer { int len; };
+int buffer_size;
+int RingBufferRead (struct ring_buffer *b);
+int RingBufferWrite (struct ring_buffer *b);
+static int bufferedOutput;
+int ffer;
@@ -0,0 +1,53 @@
+#!/bin/sh
+
+# Copyright: 2026 Universal Ctags team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+READTAGS=$3
+TAGS=$BUILDDIR/readtags-substring-match.tags
+
+. ../utils.sh
+
+if ! [ -x "${READTAGS}" ]; then
+	skip "no readtags"
+fi
+
+rm -f $TAGS $TAGS.tri
+
+run_readtags ()
+{
+	echo '#' "$@"
+	${READTAGS} -t $TAGS "$@"
+}
+
+run_all ()
+{
+	run_readtags --substring-match - uffer
+	run_readtags -i --substring-match - BUFFER
+	run_readtags --substring-match - Buffer
+	run_readtags --substring-match - ff
+	run_readtags --substring-match - nothing
+}
+
+${CTAGS} --quiet --options=NONE --kinds-C=+p -o $TAGS input.c
+
+echo '## without index'
+run_all
+
+${CTAGS} --quiet --options=NONE --kinds-C=+p --trigram-index -o $TAGS input.c
+[ -f $TAGS.tri ] || echo "no index"
+
+echo '## with index'
+run_all
+
+echo 'int ring_buffer_count;' > $BUILDDIR/readtags-substring-match-stale.c
+${CTAGS} --quiet --options=NONE -a -o $TAGS $BUILDDIR/readtags-substring-match-stale.c
+
+echo '## with stale index'
+run_readtags --substring-match - buffer_ | sed -e 's|'$BUILDDIR'|BUILDDIR|'
+
+rm -f $BUILDDIR/readtags-substring-match-stale.c
+
+rm -f $TAGS $TAGS.tri
@@ -0,0 +1,56 @@
+#!/bin/sh
+
+# Copyright: 2026 Universal Ctags team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+READTAGS=$3
+TAGS=$BUILDDIR/readtags-trigram-rewrite.tags
+
+. ../utils.sh
+
+if ! [ -x "${READTAGS}" ]; then
+	skip "no readtags"
+fi
+
+if ! stat -c %y input.c > /dev/null 2>&1; then
+	skip "no stat -c"
+fi
+
+rm -f $TAGS $TAGS.tri $TAGS.new
+
+run_readtags ()
+{
+	echo '#' "$@"
+	${READTAGS} -t $TAGS "$@"
+}
+
+make_tags ()
+{
+	${CTAGS} --quiet --options=NONE --kinds-C=+p --trigram-index -o $TAGS input.c
+	[ -f $TAGS.tri ] || echo "no index"
+	sed -e 's/buffer_size/gammer_size/g' $TAGS > $TAGS.new
+}
+
+# The rewritten tag file keeps the size and the inode of the indexed
+# one, and the second of its mtime.
+make_tags
+mtime=$(stat -c %Y $TAGS)
+cat $TAGS.new > $TAGS
+touch -d "@$mtime" $TAGS
+
+echo '## rewritten in the same second'
+run_readtags --substring-match - gammer
+
+# The replacing tag file keeps the size and the whole mtime of the
+# indexed one.
+make_tags
+mtime=$(stat -c %y $TAGS)
+mv $TAGS.new $TAGS
+touch -d "$mtime" $TAGS
+
+echo '## replaced with the same mtime'
+run_readtags --substring-match - gammer
+
+rm -f $TAGS $TAGS.tri $TAGS.new
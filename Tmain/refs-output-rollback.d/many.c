@@ -0,0 +1,4 @@
+#include <b.h>
+int v1;
+int v2;
+int v3;
@@ -0,0 +1,5 @@
+#include <a.h>
+#if X
+}
+#endif
+int g;
@@ -0,0 +1,34 @@
+#!/bin/sh
+
+# Copyright: 2026 Universal Ctags team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+READTAGS=$3
+TAGS=$BUILDDIR/refs-output-rollback.tags
+
+. ../utils.sh
+
+if ! [ -x "${READTAGS}" ]; then
+	skip "no readtags"
+fi
+
+rm -f $TAGS $TAGS.refs
+
+run_ctags ()
+{
+	echo '#' "$@"
+	${CTAGS} --quiet --options=NONE --extras=+r --fields=+r --refs-output=$TAGS.refs \
+			 "$@" -o $TAGS rescan.c many.c 2>&1
+	grep -v '^!_' $TAGS
+	${READTAGS} -t $TAGS --list-references a.h
+	${READTAGS} -t $TAGS --list-references b.h
+}
+
+# rescan.c is parsed twice; the references of the first pass are discarded.
+run_ctags
+# The references of many.c are discarded with its tags.
+run_ctags --max-tags-per-file=2
+
+rm -f $TAGS $TAGS.refs
@@ -0,0 +1,8 @@
+#include <stdio.h>
+#include "foo.h"
+#define X 1
+#undef X
+#ifdef X
+#endif
+#undef X
+int main(void){return 0;}
@@ -0,0 +1,42 @@
+#!/bin/sh
+
+# Copyright: 2026 Universal Ctags team
+# License: GPL-2
+
+CTAGS=$1
+BUILDDIR=$2
+READTAGS=$3
+TAGS=$BUILDDIR/refs-output.tags
+
+. ../utils.sh
+
+if ! [ -x "${READTAGS}" ]; then
+	skip "no readtags"
+fi
+
+rm -f $TAGS $TAGS.refs
+
+echo '#' tags
+${CTAGS} --quiet --options=NONE --extras=+r --fields=+r --refs-output=$TAGS.refs \
+		 -o $TAGS a.c b.c
+grep -v '^!_' $TAGS
+
+run_readtags ()
+{
+	echo '#' "$@"
+	${READTAGS} -t $TAGS "$@"
+}
+
+run_readtags --list-references X
+run_readtags --list-references stdio.h
+run_readtags --list-references x
+run_readtags -i --list-references x
+run_readtags -p --list-references s
+run_readtags --limit 2 --list-references X
+run_readtags --list-references no-such-name
+
+echo '#' no reference file
+${READTAGS} -t $TAGS --refs-file $TAGS.none --list-references X 2>&1 \
+	| sed -e 's|'$TAGS'|TAGS|' -e 's|^.*readtags:|readtags:|'
+
+rm -f $TAGS $TAGS.refs
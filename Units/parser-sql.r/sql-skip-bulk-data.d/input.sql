@@ -0,0 +1,31 @@
+CREATE TABLE t1 (
+    id integer,
+    name text
+);
+
+INSERT INTO t1 VALUES (1, 'CREATE TABLE fake1 (x int);'), (2, 'it''s; not the end');
+INSERT INTO t1 (id, name) VALUES
+  (3, $$CREATE TABLE fake2 (y int);$$),
+  (4, $body$ ; $$ ; $body$),
+  (5, -- CREATE TABLE fake3 (z int);
+   'a /* b'),
+  (6, '/'), (7, '~') /* ; */;
+
+COPY t1 (id, name) FROM stdin;
+8	CREATE TABLE fake4 (w int);
+9	x; y
+\.
+
+CREATE TABLE t2 (
+    id integer
+);
+
+insert into t2 values (10)
+go
+
+CREATE VIEW v1 AS SELECT * FROM t2;
+
+-- T-SQL: ; is optional
+INSERT INTO t2 VALUES (11)
+INSERT INTO t2 VALUES ('CREATE TABLE fake5 (v int)')
+CREATE TABLE t3 (id int)
@@ -11,8 +11,13 @@
 #include <string.h>		/* strerror */
 #include <stdlib.h>		/* exit */
 #include <stdio.h>		/* stderr */
+#include <errno.h>
+#include <ctype.h>		/* toupper */
+#include <limits.h>		/* LONG_MAX */
+#include <stdint.h>
 
 static const char *TagFileName = "tags";
+static const char *RefsFileName;
 static const char *ProgramName;
 static int extensionFields;
 static int SortOverride;
@@ -20,6 +25,7 @@ static sortType SortMethod;
 static int allowPrintLineNumber;
 static int debugMode;
 static int escaping;
+static unsigned long Limit;
 #ifdef READTAGS_DSL
 #include "dsl/qualifier.h"
 static QCode *Qualifier;
@@ -124,12 +130,31 @@ static tagEntry *copyTag (tagEntry *o)
 	return n;
 }
 
+static size_t copiedTagSize (const tagEntry *e)
+{
+	size_t size = sizeof (*e) + strlen (e->name) + 1;
+
+	if (e->file)
+		size += strlen (e->file) + 1;
+	if (e->address.pattern)
+		size += strlen (e->address.pattern) + 1;
+	if (e->kind)
+		size += strlen (e->kind) + 1;
+	for (unsigned short c = 0; c < e->fields.count; c++)
+		size += sizeof (e->fields.list[c])
+			+ strlen (e->fields.list[c].key) + 1
+			+ strlen (e->fields.list[c].value) + 1;
+	return size;
+}
+
 struct tagEntryHolder {
 	tagEntry *e;
+	unsigned long seq;			/* for keeping the input order of equal tags */
 };
 struct tagEntryArray {
 	int count;
 	int length;
+	size_t size;				/* memory used by the copied tags */
 	struct tagEntryHolder *a;
 };
 
@@ -141,6 +166,7 @@ struct tagEntryArray *tagEntryArrayNew (void)
 
 	a->count = 0;
 	a->length = 1024;
+	a->size = 0;
 	a->a = malloc(a->length * sizeof (a->a[0]));
 	if (!a->a)
 		perror(__FUNCTION__);
@@ -148,7 +174,7 @@ struct tagEntryArray *tagEntryArrayNew (void)
 	return a;
 }
 
-void tagEntryArrayPush (struct tagEntryArray *a, tagEntry *e)
+void tagEntryArrayPush (struct tagEntryArray *a, tagEntry *e, unsigned long seq)
 {
 	if (a->count + 1 == a->length)
 	{
@@ -163,23 +189,262 @@ void tagEntryArrayPush (struct tagEntryArray *a, tagEntry *e)
 		a->length *= 2;
 	}
 
-	a->a[a->count++].e = e;
+	a->a[a->count].e = e;
+	a->a[a->count].seq = seq;
+	a->count++;
+	a->size += copiedTagSize (e);
+}
+
+void tagEntryArrayClear (struct tagEntryArray *a)
+{
+	for (int i = 0; i < a->count; i++)
+		freeCopiedTag (a->a[i].e);
+	a->count = 0;
+	a->size = 0;
 }
 
 void tagEntryArrayFree (struct tagEntryArray *a, int freeTags)
 {
 	if (freeTags)
-	{
-		for (int i = 0; i < a->count; i++)
-			freeCopiedTag (a->a[i].e);
-	}
+		tagEntryArrayClear (a);
 	free (a->a);
 	free (a);
 }
 
+static int compareTagEntryHolder (const struct tagEntryHolder *a,
+								  const struct tagEntryHolder *b)
+{
+	int r = s_compare (a->e, b->e, Sorter);
+
+	if (r == 0 && a->seq != b->seq)
+		r = (a->seq < b->seq)? -1: 1;
+	return r;
+}
+
 static int compareTagEntry (const void *a, const void *b)
 {
-	return s_compare (((struct tagEntryHolder *)a)->e, ((struct tagEntryHolder *)b)->e, Sorter);
+	return compareTagEntryHolder (a, b);
+}
+
+/*
+ * Binary heap of tag entries ordered by the sorter.
+ * ORDER is 1 for putting the first tag at the top, and -1 for
+ * putting the last tag at the top.
+ */
+static void heapSiftUp (struct tagEntryHolder *h, int i, int order)
+{
+	while (i > 0)
+	{
+		int parent = (i - 1) / 2;
+
+		if (order * compareTagEntryHolder (h + i, h + parent) >= 0)
+			break;
+
+		struct tagEntryHolder tmp = h[i];
+		h[i] = h[parent];
+		h[parent] = tmp;
+		i = parent;
+	}
+}
+
+static void heapSiftDown (struct tagEntryHolder *h, int count, int i, int order)
+{
+	while (1)
+	{
+		int top = i;
+		int l = 2 * i + 1;
+		int r = l + 1;
+
+		if (l < count && order * compareTagEntryHolder (h + l, h + top) < 0)
+			top = l;
+		if (r < count && order * compareTagEntryHolder (h + r, h + top) < 0)
+			top = r;
+		if (top == i)
+			break;
+
+		struct tagEntryHolder tmp = h[i];
+		h[i] = h[top];
+		h[top] = tmp;
+		i = top;
+	}
+}
+
+/*
+ * When the copied tags use more memory than SORT_MEMORY_LIMIT, they are
+ * sorted and written to a temporary file (a sorted run). The sorted runs
+ * are merged when printing.
+ */
+#ifndef SORT_MEMORY_LIMIT
+#define SORT_MEMORY_LIMIT (64 * 1024 * 1024)
+#endif
+
+struct sortedRuns {
+	int count;
+	FILE **fp;
+};
+
+static void failInRun (const char *what)
+{
+	fprintf (stderr, "%s: failed in %s a sorted run: %s\n",
+			 ProgramName, what, strerror (errno));
+	exit (1);
+}
+
+static void writeString (FILE *fp, const char *s)
+{
+	/* 0 is for NULL. */
+	size_t len = s? strlen (s) + 1: 0;
+
+	if (fwrite (&len, sizeof (len), 1, fp) != 1
+		|| (len > 0 && fwrite (s, 1, len, fp) != len))
+		failInRun ("writing");
+}
+
+static int readString (FILE *fp, const char **s)
+{
+	size_t len;
+	char *str;
+
+	if (fread (&len, sizeof (len), 1, fp) != 1)
+	{
+		if (feof (fp))
+			return 0;
+		failInRun ("reading");
+	}
+
+	if (len == 0)
+	{
+		*s = NULL;
+		return 1;
+	}
+
+	str = malloc (len);
+	if (!str)
+		perror (__FUNCTION__);
+	if (fread (str, 1, len, fp) != len)
+		failInRun ("reading");
+	*s = str;
+	return 1;
+}
+
+static void writeTag (FILE *fp, const tagEntry *e)
+{
+	writeString (fp, e->name);
+	writeString (fp, e->file);
+	writeString (fp, e->address.pattern);
+	writeString (fp, e->kind);
+	if (fwrite (&e->address.lineNumber, sizeof (e->address.lineNumber), 1, fp) != 1
+		|| fwrite (&e->fileScope, sizeof (e->fileScope), 1, fp) != 1
+		|| fwrite (&e->fields.count, sizeof (e->fields.count), 1, fp) != 1)
+		failInRun ("writing");
+	for (unsigned short c = 0; c < e->fields.count; c++)
+	{
+		writeString (fp, e->fields.list[c].key);
+		writeString (fp, e->fields.list[c].value);
+	}
+}
+
+/* Return NULL at the end of the run. */
+static tagEntry *readTag (FILE *fp)
+{
+	const char *name;
+	tagEntry *e;
+
+	if (!readString (fp, &name))
+		return NULL;
+
+	e = calloc (1, sizeof (*e));
+	if (!e)
+		perror (__FUNCTION__);
+	e->name = name;
+
+	if (!readString (fp, &e->file)
+		|| !readString (fp, &e->address.pattern)
+		|| !readString (fp, &e->kind)
+		|| fread (&e->address.lineNumber, sizeof (e->address.lineNumber), 1, fp) != 1
+		|| fread (&e->fileScope, sizeof (e->fileScope), 1, fp) != 1
+		|| fread (&e->fields.count, sizeof (e->fields.count), 1, fp) != 1)
+		failInRun ("reading");
+
+	if (e->fields.count == 0)
+		return e;
+
+	e->fields.list = malloc (e->fields.count * sizeof (*e->fields.list));
+	if (!e->fields.list)
+		perror (__FUNCTION__);
+
+	for (unsigned short c = 0; c < e->fields.count; c++)
+	{
+		if (!readString (fp, &e->fields.list[c].key)
+			|| !readString (fp, &e->fields.list[c].value))
+			failInRun ("reading");
+	}
+
+	return e;
+}
+
+static void spillSortedRun (struct tagEntryArray *a, struct sortedRuns *runs)
+{
+	FILE *fp = tmpfile ();
+	if (!fp)
+		failInRun ("creating");
+
+	qsort (a->a, a->count, sizeof (a->a[0]), compareTagEntry);
+	for (int i = 0; i < a->count; i++)
+		writeTag (fp, a->a[i].e);
+	if (fflush (fp) != 0)
+		failInRun ("writing");
+	rewind (fp);
+	tagEntryArrayClear (a);
+
+	FILE **tmp = realloc (runs->fp, sizeof (runs->fp[0]) * (runs->count + 1));
+	if (!tmp)
+		perror (__FUNCTION__);
+	runs->fp = tmp;
+	runs->fp[runs->count++] = fp;
+}
+
+static void mergeSortedRuns (struct sortedRuns *runs,
+							 void (* actionfn) (const tagEntry *))
+{
+	/* The index of the run is used as seq. Runs are made in the input
+	 * order, so equal tags are printed in the input order. */
+	struct tagEntryHolder *h = malloc (sizeof (h[0]) * runs->count);
+	int count = 0;
+
+	if (!h)
+		perror (__FUNCTION__);
+
+	for (int r = 0; r < runs->count; r++)
+	{
+		tagEntry *e = readTag (runs->fp[r]);
+		if (e)
+		{
+			h[count].e = e;
+			h[count].seq = r;
+			heapSiftUp (h, count++, 1);
+		}
+	}
+
+	while (count > 0)
+	{
+		tagEntry *e = h[0].e;
+
+		(* actionfn) (e);
+		freeCopiedTag (e);
+
+		e = readTag (runs->fp[h[0].seq]);
+		if (e)
+			h[0].e = e;
+		else
+			h[0] = h[--count];
+		heapSiftDown (h, count, 0, 1);
+	}
+
+	free (h);
+	for (int r = 0; r < runs->count; r++)
+		fclose (runs->fp[r]);
+	free (runs->fp);
 }
 
 static void walkTags (tagFile *const file, tagEntry *first_entry,
@@ -187,6 +452,9 @@ static void walkTags (tagFile *const file, tagEntry *first_entry,
 					  void (* actionfn) (const tagEntry *))
 {
 	struct tagEntryArray *a = NULL;
+	struct sortedRuns runs = { .count = 0, .fp = NULL };
+	unsigned long seq = 0;
+	unsigned long printed = 0;
 
 	if (Sorter)
 		a = tagEntryArrayNew ();
@@ -205,21 +473,55 @@ static void walkTags (tagFile *const file, tagEntry *first_entry,
 			}
 		}
 
-		if (a)
+		if (a && Limit)
+		{
+			/* Keep only the first Limit tags. The last one of them is
+			 * at the top of the heap. */
+			struct tagEntryHolder h = { .e = first_entry, .seq = seq++ };
+
+			if ((unsigned long)a->count < Limit)
+			{
+				tagEntryArrayPush (a, copyTag (first_entry), h.seq);
+				heapSiftUp (a->a, a->count - 1, -1);
+			}
+			else if (compareTagEntryHolder (&h, a->a) < 0)
+			{
+				freeCopiedTag (a->a[0].e);
+				a->a[0].e = copyTag (first_entry);
+				a->a[0].seq = h.seq;
+				heapSiftDown (a->a, a->count, 0, -1);
+			}
+		}
+		else if (a)
 		{
 			tagEntry *e = copyTag (first_entry);
-			tagEntryArrayPush (a, e);
+			tagEntryArrayPush (a, e, seq++);
+			if (a->size > SORT_MEMORY_LIMIT)
+				spillSortedRun (a, &runs);
 		}
 		else
+		{
 			(* actionfn) (first_entry);
+			if (Limit && ++printed == Limit)
+				break;
+		}
 	} while ( (*nextfn) (file, first_entry) == TagSuccess);
 
 
 	if (a)
 	{
-		qsort (a->a, a->count, sizeof (a->a[0]), compareTagEntry);
-		for (int i = 0; i < a->count; i++)
-			(* actionfn) (a->a[i].e);
+		if (runs.count > 0)
+		{
+			if (a->count > 0)
+				spillSortedRun (a, &runs);
+			mergeSortedRuns (&runs, actionfn);
+		}
+		else
+		{
+			qsort (a->a, a->count, sizeof (a->a[0]), compareTagEntry);
+			for (int i = 0; i < a->count; i++)
+				(* actionfn) (a->a[i].e);
+		}
 		tagEntryArrayFree (a, 1);
 	}
 }
@@ -228,8 +530,14 @@ static void walkTags (tagFile *const file, tagEntry *first_entry,
 					  tagResult (* nextfn) (tagFile *const, tagEntry *),
 					  void (* actionfn) (const tagEntry *))
 {
+	unsigned long printed = 0;
+
 	do
+	{
 		(* actionfn) (first_entry);
+		if (Limit && ++printed == Limit)
+			break;
+	}
 	while ( (*nextfn) (file, first_entry) == TagSuccess);
 }
 #endif
@@ -283,6 +591,310 @@ static void listTags (int pseudoTags)
 	}
 }
 
+/* Reading the reference file written with "ctags --refs-output".
+ * See main/refs.c of ctags for its format. Only the strings and the
+ * entries of the name table needed for a lookup are read. */
+#define REFS_MAGIC         "CTAGSREF"
+#define REFS_VERSION       2
+#define REFS_HEADER_SIZE   28
+#define REFS_NAME_ENTRY_SIZE 12
+#define REFS_STRING_OFFSET_SIZE 8
+
+/* The last string read for each use, so that a string repeated in
+ * the groups, like the roles, is not read again. */
+enum refsStringSlot {
+	REFS_NAME,
+	REFS_FILE,
+	REFS_LANGUAGE,
+	REFS_KIND,
+	REFS_ROLES,
+	REFS_SLOT_COUNT,
+};
+
+struct refsString {
+	char *buffer;
+	size_t size;
+	uint64_t index;				/* UINT64_MAX if not read yet */
+};
+
+struct refsFile {
+	const char *fileName;
+	FILE *fp;					/* for the names and the groups */
+	FILE *stringFp;				/* for the strings */
+	uint32_t stringCount;
+	uint32_t nameCount;
+	uint64_t stringTableEnd;
+	uint64_t nameTable;
+	struct refsString strings [REFS_SLOT_COUNT];
+};
+
+static uint64_t readUint (const unsigned char *p, int bytes)
+{
+	uint64_t n = 0;
+
+	for (int i = 0; i < bytes; i++)
+		n |= ((uint64_t) p [i]) << (8 * i);
+	return n;
+}
+
+static int readLEB128 (FILE *fp, uint64_t *n)
+{
+	int shift = 0;
+	int c;
+
+	*n = 0;
+	do
+	{
+		c = getc (fp);
+		if (c == EOF || shift > 63)
+			return 0;
+		*n |= ((uint64_t) (c & 0x7f)) << shift;
+		shift += 7;
+	}
+	while (c & 0x80);
+	return 1;
+}
+
+static void refsFileBroken (const char *const fileName)
+{
+	fprintf (stderr, "%s: broken reference file: %s\n", ProgramName, fileName);
+	exit (1);
+}
+
+static FILE *refsFileOpenStream (const char *const fileName)
+{
+	FILE *fp = fopen (fileName, "rb");
+
+	if (fp == NULL)
+	{
+		fprintf (stderr, "%s: cannot open reference file: %s: %s\n",
+				 ProgramName, strerror (errno), fileName);
+		exit (1);
+	}
+	return fp;
+}
+
+static int refsFileSeek (FILE *fp, uint64_t offset)
+{
+	return offset <= LONG_MAX && fseek (fp, (long) offset, SEEK_SET) == 0;
+}
+
+static void refsFileOpen (struct refsFile *refs, const char *const fileName)
+{
+	unsigned char header [REFS_HEADER_SIZE];
+	uint64_t stringTableSize;
+
+	memset (refs, 0, sizeof (*refs));
+	refs->fileName = fileName;
+	refs->fp = refsFileOpenStream (fileName);
+
+	if (fread (header, 1, sizeof (header), refs->fp) != sizeof (header)
+		|| memcmp (header, REFS_MAGIC, strlen (REFS_MAGIC)) != 0
+		|| readUint (header + 8, 4) != REFS_VERSION)
+		refsFileBroken (fileName);
+
+	refs->stringCount = (uint32_t) readUint (header + 12, 4);
+	refs->nameCount = (uint32_t) readUint (header + 16, 4);
+	stringTableSize = readUint (header + 20, 8);
+	if (stringTableSize > UINT64_MAX - REFS_HEADER_SIZE
+		- (uint64_t) refs->stringCount * REFS_STRING_OFFSET_SIZE)
+		refsFileBroken (fileName);
+	refs->stringTableEnd = REFS_HEADER_SIZE + stringTableSize;
+	refs->nameTable = refs->stringTableEnd
+		+ (uint64_t) refs->stringCount * REFS_STRING_OFFSET_SIZE;
+
+	refs->stringFp = refsFileOpenStream (fileName);
+	for (int i = 0; i < REFS_SLOT_COUNT; i++)
+		refs->strings [i].index = UINT64_MAX;
+}
+
+static void refsFileClose (struct refsFile *refs)
+{
+	fclose (refs->fp);
+	fclose (refs->stringFp);
+	for (int i = 0; i < REFS_SLOT_COUNT; i++)
+		free (refs->strings [i].buffer);
+}
+
+/* Read the string at INDEX through the offset table into SLOT. */
+static const char *refsString (struct refsFile *refs, uint64_t index,
+							   enum refsStringSlot slot)
+{
+	struct refsString *s = refs->strings + slot;
+	unsigned char entry [REFS_STRING_OFFSET_SIZE];
+	uint64_t offset;
+	size_t length = 0;
+	int c;
+
+	if (s->index == index)
+		return s->buffer;
+	s->index = UINT64_MAX;
+
+	if (index >= refs->stringCount
+		|| !refsFileSeek (refs->stringFp, refs->stringTableEnd
+						  + index * REFS_STRING_OFFSET_SIZE)
+		|| fread (entry, 1, sizeof (entry), refs->stringFp) != sizeof (entry))
+		refsFileBroken (refs->fileName);
+	offset = readUint (entry, REFS_STRING_OFFSET_SIZE);
+	if (offset < REFS_HEADER_SIZE || offset >= refs->stringTableEnd
+		|| !refsFileSeek (refs->stringFp, offset))
+		refsFileBroken (refs->fileName);
+
+	do
+	{
+		c = getc (refs->stringFp);
+		if (c == EOF || offset + length >= refs->stringTableEnd)
+			refsFileBroken (refs->fileName);
+		if (length == s->size)
+		{
+			s->size = s->size? s->size * 2: 64;
+			s->buffer = realloc (s->buffer, s->size);
+			if (s->buffer == NULL)
+			{
+				perror (__FUNCTION__);
+				exit (1);
+			}
+		}
+		s->buffer [length++] = (char) c;
+	}
+	while (c != '\0');
+
+	s->index = index;
+	return s->buffer;
+}
+
+/* Read the I-th entry of the name table, and return its name. */
+static const char *refsName (struct refsFile *refs, uint32_t i,
+							 uint64_t *groupsOffset)
+{
+	unsigned char entry [REFS_NAME_ENTRY_SIZE];
+
+	if (!refsFileSeek (refs->fp, refs->nameTable
+					   + (uint64_t) i * REFS_NAME_ENTRY_SIZE)
+		|| fread (entry, 1, sizeof (entry), refs->fp) != sizeof (entry))
+		refsFileBroken (refs->fileName);
+	if (groupsOffset)
+		*groupsOffset = readUint (entry + 4, 8);
+	return refsString (refs, readUint (entry, 4), REFS_NAME);
+}
+
+/* Return the index of the first name not less than NAME in byte order.
+ * The names matching NAME exactly or as a prefix start from there. */
+static uint32_t refsLowerBound (struct refsFile *refs, const char *const name)
+{
+	uint32_t lo = 0, hi = refs->nameCount;
+
+	while (lo < hi)
+	{
+		uint32_t mid = lo + (hi - lo) / 2;
+
+		if (strcmp (refsName (refs, mid, NULL), name) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static int matchName (const char *tagName, const char *name, const int options)
+{
+	size_t length = strlen (name);
+
+	if (!(options & TAG_PARTIALMATCH) && strlen (tagName) != length)
+		return 0;
+	if (options & TAG_IGNORECASE)
+	{
+		for (size_t i = 0; i < length; i++)
+		{
+			if (toupper ((unsigned char) tagName [i]) != toupper ((unsigned char) name [i]))
+				return 0;
+		}
+		return 1;
+	}
+	return strncmp (tagName, name, length) == 0;
+}
+
+static void listReferences (const char *const name, const int options)
+{
+	struct refsFile refs;
+	char *defaultFileName = NULL;
+	const char *fileName = RefsFileName;
+	unsigned long printed = 0;
+	uint32_t i;
+
+	if (fileName == NULL)
+	{
+		defaultFileName = malloc (strlen (TagFileName) + sizeof (".refs"));
+		if (defaultFileName == NULL)
+		{
+			perror (__FUNCTION__);
+			exit (1);
+		}
+		strcpy (defaultFileName, TagFileName);
+		strcat (defaultFileName, ".refs");
+		fileName = defaultFileName;
+	}
+
+	refsFileOpen (&refs, fileName);
+	if (debugMode)
+		fprintf (stderr, "%s: searching for references of \"%s\" in \"%s\"\n",
+				 ProgramName, name, fileName);
+
+	/* The names are sorted in byte order; the ones matching NAME are
+	 * adjacent unless the case is ignored. */
+	i = (options & TAG_IGNORECASE)? 0: refsLowerBound (&refs, name);
+	for (; i < refs.nameCount; i++)
+	{
+		uint64_t offset, groups;
+		const char *tagName = refsName (&refs, i, &offset);
+
+		if (!matchName (tagName, name, options))
+		{
+			if (options & TAG_IGNORECASE)
+				continue;
+			break;
+		}
+
+		if (!refsFileSeek (refs.fp, offset)
+			|| !readLEB128 (refs.fp, &groups))
+			refsFileBroken (fileName);
+
+		for (uint64_t g = 0; g < groups; g++)
+		{
+			uint64_t file, language, kind, count;
+			uint64_t line = 0;
+
+			if (!(readLEB128 (refs.fp, &file)
+				  && readLEB128 (refs.fp, &language)
+				  && readLEB128 (refs.fp, &kind)
+				  && readLEB128 (refs.fp, &count)))
+				refsFileBroken (fileName);
+
+			for (uint64_t k = 0; k < count; k++)
+			{
+				uint64_t delta, roles;
+
+				if (!readLEB128 (refs.fp, &delta) || !readLEB128 (refs.fp, &roles))
+					refsFileBroken (fileName);
+				line += delta;
+				printf ("%s\t%s\t%llu;\"\tkind:%s\tlanguage:%s\troles:%s\n",
+						tagName,
+						refsString (&refs, file, REFS_FILE),
+						(unsigned long long) line,
+						refsString (&refs, kind, REFS_KIND),
+						refsString (&refs, language, REFS_LANGUAGE),
+						refsString (&refs, roles, REFS_ROLES));
+				if (Limit && ++printed == Limit)
+					goto out;
+			}
+		}
+	}
+
+ out:
+	refsFileClose (&refs);
+	free (defaultFileName);
+}
+
 static const char *const Usage =
 	"Find tag file entries matching specified names.\n\n"
 	"Usage: \n"
@@ -303,6 +915,8 @@ static const char *const Usage =
 	"        \"-\" indicates arguments after this as NAME(s) even if they start with -.\n"
 	"    -D | --list-pseudo-tags\n"
 	"        List pseudo tags.\n"
+	"    --list-references NAME\n"
+	"        List references of NAME in the reference file.\n"
 	"Options:\n"
 	"    -d | --debug\n"
 	"        Turn on debugging output.\n"
@@ -312,12 +926,18 @@ static const char *const Usage =
 	"        Include extension fields in output.\n"
 	"    -i | --icase-match\n"
 	"        Perform case-insensitive matching in the NAME action.\n"
+	"    --limit N\n"
+	"        Print only the first N tags listed by ACTION.\n"
 	"    -n | --line-number\n"
 	"        Also include the line number field when -e option is given.\n"
 	"    -p | --prefix-match\n"
 	"        Perform prefix matching in the NAME action.\n"
+	"    --substring-match\n"
+	"        Perform substring matching in the NAME action.\n"
 	"    -t TAGFILE | --tag-file TAGFILE\n"
 	"        Use specified tag file (default: \"tags\").\n"
+	"    --refs-file REFSFILE\n"
+	"        Use specified reference file (default: TAGFILE.refs).\n"
 	"    -s[0|1|2] | --override-sort-detection METHOD\n"
 	"        Override sort detection of tag file.\n"
 	"        METHOD: unsorted|sorted|foldcase\n"
@@ -443,6 +1063,8 @@ extern int main (int argc, char **argv)
 				options |= TAG_IGNORECASE;
 			else if (strcmp (optname, "prefix-match") == 0)
 				options |= TAG_PARTIALMATCH;
+			else if (strcmp (optname, "substring-match") == 0)
+				options |= TAG_SUBSTRINGMATCH;
 			else if (strcmp (optname, "list") == 0)
 			{
 				listTags (0);
@@ -450,6 +1072,51 @@ extern int main (int argc, char **argv)
 			}
 			else if (strcmp (optname, "line-number") == 0)
 				allowPrintLineNumber = 1;
+			else if (strcmp (optname, "limit") == 0)
+			{
+				if (i + 1 < argc)
+				{
+					const char *limit_spec = argv [++i];
+					char *end;
+
+					errno = 0;
+					Limit = strtoul (limit_spec, &end, 10);
+					if (errno || end == limit_spec || *end != '\0'
+						|| Limit == 0 || limit_spec [0] == '-')
+					{
+						fprintf (stderr, "%s: wrong number for --%s option: %s\n",
+								 ProgramName, optname, limit_spec);
+						exit (1);
+					}
+				}
+				else
+				{
+					fprintf (stderr, "%s: missing number for --%s option\n",
+							 ProgramName, optname);
+					exit (1);
+				}
+			}
+			else if (strcmp (optname, "list-references") == 0)
+			{
+				if (i + 1 < argc)
+				{
+					listReferences (argv [++i], options);
+					actionSupplied = 1;
+				}
+				else
+				{
+					fprintf (stderr, "%s: missing name for --%s option\n",
+							 ProgramName, optname);
+					exit (1);
+				}
+			}
+			else if (strcmp (optname, "refs-file") == 0)
+			{
+				if (i + 1 < argc)
+					RefsFileName = argv [++i];
+				else
+					printUsage (stderr, 1);
+			}
 			else if (strcmp (optname, "tag-file") == 0)
 			{
 				if (i + 1 < argc)
@@ -15,6 +15,13 @@
 #include <stdio.h>
 #include <errno.h>
 #include <sys/types.h>  /* to declare off_t */
+#include <sys/stat.h>
+#if defined (__unix__) || (defined (__APPLE__) && defined (__MACH__))
+# define USE_MMAP
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
 
 #include "readtags.h"
 
@@ -23,6 +30,13 @@
 */
 #define TAB '\t'
 
+/* See main/trigram.c of Universal Ctags about the format. */
+#define TRIGRAM_INDEX_MAGIC   "CTAGSTRI"
+#define TRIGRAM_INDEX_VERSION 2
+#define TRIGRAM_INDEX_SUFFIX  ".tri"
+#define TRIGRAM_HEADER_SIZE   44
+#define TRIGRAM_ENTRY_SIZE    16
+
 
 /*
 *   DATA DECLARATIONS
@@ -32,6 +46,12 @@ typedef struct {
 	char *buffer;
 } vstring;
 
+typedef struct {
+	unsigned long trigram;
+	unsigned long count;
+	off_t offset;
+} trigramEntry;
+
 /* Information about current tag file */
 struct sTagFile {
 		/* has the file been opened and this structure initialized? */
@@ -40,8 +60,14 @@ struct sTagFile {
 	short format;
 		/* how is the tag file sorted? */
 	sortType sortMethod;
-		/* pointer to file structure */
+		/* pointer to file structure (NULL for a cursor) */
 	FILE* fp;
+		/* tag database read by a cursor (NULL unless a cursor) */
+	const tagDatabase *db;
+		/* read position of a cursor in the tag database */
+	off_t offset;
+		/* path of the tag file (NULL for a cursor) */
+	char *path;
 		/* file position of first character of `line' */
 	off_t pos;
 		/* size of tag file in seekable positions */
@@ -62,7 +88,28 @@ struct sTagFile {
 			short partial;
 				/* ignoring case */
 			short ignorecase;
+				/* performing substring match */
+			short substring;
+				/* is the trigram index used for the search? */
+			short indexed;
+				/* positions of lines found with the trigram index */
+			off_t *candidates;
+				/* number of entries in `candidates' */
+			size_t candidateCount;
+				/* next entry to try in `candidates' */
+			size_t candidateIndex;
 	} search;
+		/* trigram index of tag names */
+	struct {
+				/* has loading the index been tried? */
+			short loaded;
+				/* the index file (NULL if not available) */
+			FILE *fp;
+				/* number of entries in `table' */
+			unsigned long count;
+				/* trigrams sorted in ascending order */
+			trigramEntry *table;
+	} trigram;
 		/* miscellaneous extension fields */
 	struct {
 				/* number of entries in `list' */
@@ -83,6 +130,31 @@ struct sTagFile {
 	} program;
 };
 
+/* Contents and pseudo tags of a tag file shared by cursors.
+ * Nothing in this structure is modified after tagsOpenDatabase(). */
+struct sTagDatabase {
+		/* path of the tag file */
+	char *path;
+		/* contents of the tag file */
+	const char *data;
+		/* size of the contents */
+	off_t size;
+		/* is `data' mapped with mmap()? */
+	int mapped;
+		/* file position of the first regular tag */
+	off_t firstTag;
+		/* format of tag file */
+	short format;
+		/* how is the tag file sorted? */
+	sortType sortMethod;
+	struct {
+		char *author;
+		char *name;
+		char *url;
+		char *version;
+	} program;
+};
+
 /*
 *   DATA DEFINITIONS
 */
@@ -238,6 +310,37 @@ static int growString (vstring *s)
 	return result;
 }
 
+static off_t tellTagFile (tagFile *const file)
+{
+	if (file->db)
+		return file->offset;
+	return ftell (file->fp);
+}
+
+static int seekTagFile (tagFile *const file, const off_t pos)
+{
+	if (file->db)
+	{
+		file->offset = pos;
+		return 0;
+	}
+	return fseek (file->fp, pos, SEEK_SET);
+}
+
+static off_t sizeOfTagFile (tagFile *const file)
+{
+	off_t size;
+
+	if (file->db)
+		return file->db->size;
+
+	if (fseek (file->fp, 0, SEEK_END) == -1)
+		return -1;
+	size = ftell (file->fp);
+	rewind (file->fp);
+	return size;
+}
+
 /* Copy name of tag out of tag line */
 static void copyName (tagFile *const file)
 {
@@ -259,11 +362,60 @@ static void copyName (tagFile *const file)
 	file->name.buffer [length] = '\0';
 }
 
+/* Same as readTagLineRaw() but for a cursor. The line is copied from the
+ * tag database to the buffer of the cursor. */
+static int readTagLineFromDatabase (tagFile *const file, int *err)
+{
+	const tagDatabase *const db = file->db;
+	const char *start, *end;
+	size_t length;
+
+	if (err)
+		*err = 0;
+
+	file->pos = file->offset;
+	if (file->offset >= db->size)
+		return 0;
+
+	start = db->data + file->offset;
+	end = memchr (start, '\n', (size_t) (db->size - file->offset));
+	if (end == NULL)
+	{
+		length = (size_t) (db->size - file->offset);
+		file->offset = db->size;
+	}
+	else
+	{
+		length = (size_t) (end - start);
+		file->offset += length + 1;
+	}
+	while (length > 0  &&  start [length - 1] == '\r')
+		--length;
+
+	while (length + 1 > file->line.size)
+	{
+		if (! growString (&file->line))
+		{
+			if (err)
+				*err = ENOMEM;
+			return 0;
+		}
+	}
+	memcpy (file->line.buffer, start, length);
+	file->line.buffer [length] = '\0';
+
+	copyName (file);
+	return 1;
+}
+
 static int readTagLineRaw (tagFile *const file, int *err)
 {
 	int result = 1;
 	int reReadLine;
 
+	if (file->db)
+		return readTagLineFromDatabase (file, err);
+
 	/*  If reading the line places any character other than a null or a
 	 *  newline at the last character position in the buffer (one less than
 	 *  the buffer size), then we must resize the buffer and reattempt to read
@@ -586,7 +738,7 @@ static int isPseudoTagLine (const char *buffer)
 
 static int readPseudoTags (tagFile *const file, tagFileInfo *const info)
 {
-	fpos_t startOfLine;
+	off_t startOfLine;
 	int err = 0;
 	const size_t prefixLength = strlen (PseudoTagPrefix);
 	if (info != NULL)
@@ -600,7 +752,7 @@ static int readPseudoTags (tagFile *const file, tagFileInfo *const info)
 	}
 	while (1)
 	{
-		fgetpos (file->fp, &startOfLine);
+		startOfLine = tellTagFile (file);
 		if (! readTagLineFull (file, &err))
 			break;
 		if (!isPseudoTagLine (file->line.buffer))
@@ -635,7 +787,7 @@ static int readPseudoTags (tagFile *const file, tagFileInfo *const info)
 			}
 		}
 	}
-	fsetpos (file->fp, &startOfLine);
+	seekTagFile (file, startOfLine);
 	return err;
 }
 
@@ -646,78 +798,109 @@ static int doesFilePointPseudoTag (tagFile *const file, void *unused)
 
 static void gotoFirstLogicalTag (tagFile *const file)
 {
-	fpos_t startOfLine;
+	off_t startOfLine;
+
+	if (file->db)
+	{
+		seekTagFile (file, file->db->firstTag);
+		return;
+	}
+
 	rewind (file->fp);
 	while (1)
 	{
-		fgetpos (file->fp, &startOfLine);
+		startOfLine = tellTagFile (file);
 		if (! readTagLine (file))
 			break;
 		if (!isPseudoTagLine (file->line.buffer))
 			break;
 	}
-	fsetpos (file->fp, &startOfLine);
+	seekTagFile (file, startOfLine);
 }
 
-static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
+static void unloadTrigramIndex (tagFile *const file)
+{
+	if (file->trigram.fp != NULL)
+		fclose (file->trigram.fp);
+	free (file->trigram.table);
+	file->trigram.fp = NULL;
+	file->trigram.table = NULL;
+	file->trigram.count = 0;
+}
+
+static void deallocate (tagFile *const file)
+{
+	free (file->line.buffer);
+	free (file->name.buffer);
+	free (file->fields.list);
+	free (file);
+}
+
+static tagFile *allocate (void)
 {
 	tagFile *result = (tagFile*) calloc ((size_t) 1, sizeof (tagFile));
-	if (result != NULL)
-	{
-		if (growString (&result->line) == 0)
-			goto mem_error;
-		if (growString (&result->name) == 0)
-			goto mem_error;
-		result->fields.max = 20;
-		result->fields.list = (tagExtensionField*) calloc (
-			result->fields.max, sizeof (tagExtensionField));
-		if (result->fields.list == NULL)
-			goto mem_error;
-		result->fp = fopen (filePath, "rb");
-		if (result->fp == NULL)
-		{
-			if (info)
-				info->status.error_number = errno;
-			goto file_error;
-		}
-		else
-		{
-			if (fseek (result->fp, 0, SEEK_END) == -1)
-			{
-				if (info)
-					info->status.error_number = errno;
-				goto file_error;
-			}
-			result->size = ftell (result->fp);
-			if (result->size == -1)
-			{
-				if (info)
-					info->status.error_number = errno;
-				goto file_error;
-			}
-			rewind (result->fp);
+	if (result == NULL)
+		return NULL;
+
+	if (growString (&result->line) == 0)
+		goto mem_error;
+	if (growString (&result->name) == 0)
+		goto mem_error;
+	result->fields.max = 20;
+	result->fields.list = (tagExtensionField*) calloc (
+		result->fields.max, sizeof (tagExtensionField));
+	if (result->fields.list == NULL)
+		goto mem_error;
+	return result;
 
-			if (info)
-				info->status.error_number = readPseudoTags (result, info);
-			if (info && info->status.error_number)
-				goto file_error;
+ mem_error:
+	deallocate (result);
+	return NULL;
+}
 
-			if (info)
-				info->status.opened = 1;
-			result->initialized = 1;
-		}
+static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
+{
+	tagFile *result = allocate ();
+	if (result == NULL)
+		goto mem_error;
+
+	result->fp = fopen (filePath, "rb");
+	if (result->fp == NULL)
+	{
+		if (info)
+			info->status.error_number = errno;
+		goto file_error;
 	}
+
+	result->size = sizeOfTagFile (result);
+	if (result->size == -1)
+	{
+		if (info)
+			info->status.error_number = errno;
+		goto file_error;
+	}
+
+	if (info)
+		info->status.error_number = readPseudoTags (result, info);
+	if (info && info->status.error_number)
+		goto file_error;
+
+	if (info)
+		info->status.opened = 1;
+	result->path = duplicate (filePath);
+	result->initialized = 1;
 	return result;
+
  mem_error:
 	if (info)
 		info->status.error_number = 0;
  file_error:
-	free (result->line.buffer);
-	free (result->name.buffer);
-	free (result->fields.list);
-	if (result->fp)
-		fclose (result->fp);
-	free (result);
+	if (result)
+	{
+		if (result->fp)
+			fclose (result->fp);
+		deallocate (result);
+	}
 	if (info)
 		info->status.opened = 0;
 	return NULL;
@@ -725,7 +908,8 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 
 static void terminate (tagFile *const file)
 {
-	fclose (file->fp);
+	if (file->fp)
+		fclose (file->fp);
 
 	free (file->line.buffer);
 	free (file->name.buffer);
@@ -741,12 +925,189 @@ static void terminate (tagFile *const file)
 		free (file->program.version);
 	if (file->search.name != NULL)
 		free (file->search.name);
+	free (file->search.candidates);
+	unloadTrigramIndex (file);
+	free (file->path);
 
 	memset (file, 0, sizeof (tagFile));
 
 	free (file);
 }
 
+/* Returns 0 or errno. */
+static int loadDatabase (tagDatabase *const db, const char *const filePath)
+{
+#ifdef USE_MMAP
+	struct stat st;
+	void *data;
+	int fd = open (filePath, O_RDONLY);
+	if (fd == -1)
+		return errno;
+
+	if (fstat (fd, &st) == -1)
+		goto error;
+
+	db->size = st.st_size;
+	if (db->size > 0)
+	{
+		data = mmap (NULL, (size_t) db->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+			goto error;
+		db->data = data;
+		db->mapped = 1;
+	}
+	close (fd);
+	return 0;
+ error:
+	{
+		int err = errno;
+		close (fd);
+		return err;
+	}
+#else
+	char *data;
+	int err = 0;
+	FILE *fp = fopen (filePath, "rb");
+	if (fp == NULL)
+		return errno;
+
+	if (fseek (fp, 0, SEEK_END) == -1
+		|| (db->size = ftell (fp)) == -1)
+	{
+		err = errno;
+		goto out;
+	}
+	rewind (fp);
+
+	if (db->size > 0)
+	{
+		data = malloc ((size_t) db->size);
+		if (data == NULL)
+		{
+			err = ENOMEM;
+			goto out;
+		}
+		if (fread (data, 1, (size_t) db->size, fp) != (size_t) db->size)
+		{
+			err = ferror (fp)? errno: EIO;
+			free (data);
+			goto out;
+		}
+		db->data = data;
+	}
+ out:
+	fclose (fp);
+	return err;
+#endif
+}
+
+static void unloadDatabase (tagDatabase *const db)
+{
+	if (db->data == NULL)
+		return;
+#ifdef USE_MMAP
+	if (db->mapped)
+		munmap ((void *) db->data, (size_t) db->size);
+#else
+	free ((void *) db->data);
+#endif
+}
+
+static tagFile *openCursor (const tagDatabase *const db)
+{
+	tagFile *result = allocate ();
+	if (result == NULL)
+		return NULL;
+
+	result->db = db;
+	result->size = db->size;
+	result->offset = db->firstTag;
+	result->format = db->format;
+	result->sortMethod = db->sortMethod;
+	result->initialized = 1;
+	return result;
+}
+
+static void fillInfo (const tagDatabase *const db, tagFileInfo *const info)
+{
+	info->status.opened = 1;
+	info->status.error_number = 0;
+	info->file.format     = db->format;
+	info->file.sort       = db->sortMethod;
+	info->program.author  = db->program.author;
+	info->program.name    = db->program.name;
+	info->program.url     = db->program.url;
+	info->program.version = db->program.version;
+}
+
+static void terminateDatabase (tagDatabase *const db)
+{
+	unloadDatabase (db);
+	free (db->path);
+	free (db->program.author);
+	free (db->program.name);
+	free (db->program.url);
+	free (db->program.version);
+	free (db);
+}
+
+static tagDatabase *initializeDatabase (const char *const filePath,
+										tagFileInfo *const info)
+{
+	tagFile *cursor;
+	int err;
+	tagDatabase *db = (tagDatabase*) calloc ((size_t) 1, sizeof (tagDatabase));
+	if (db == NULL)
+	{
+		err = 0;
+		goto error;
+	}
+
+	err = loadDatabase (db, filePath);
+	if (err)
+		goto error;
+	db->path = duplicate (filePath);
+
+	/* Parse the pseudo tags once with a temporary cursor. */
+	cursor = openCursor (db);
+	if (cursor == NULL)
+	{
+		err = 0;
+		goto error;
+	}
+	cursor->format = 1;
+	cursor->sortMethod = TAG_UNSORTED;
+	err = readPseudoTags (cursor, NULL);
+	db->firstTag = cursor->offset;
+	db->format = cursor->format;
+	db->sortMethod = cursor->sortMethod;
+	db->program.author = cursor->program.author;
+	db->program.name = cursor->program.name;
+	db->program.url = cursor->program.url;
+	db->program.version = cursor->program.version;
+	cursor->program.author = NULL;
+	cursor->program.name = NULL;
+	cursor->program.url = NULL;
+	cursor->program.version = NULL;
+	terminate (cursor);
+	if (err)
+		goto error;
+
+	if (info)
+		fillInfo (db, info);
+	return db;
+
+ error:
+	if (db)
+		terminateDatabase (db);
+	if (info)
+	{
+		info->status.opened = 0;
+		info->status.error_number = err;
+	}
+	return NULL;
+}
+
 static tagResult readNext (tagFile *const file, tagEntry *const entry)
 {
 	tagResult result;
@@ -781,7 +1142,7 @@ static const char *readFieldValue (
 static int readTagLineSeek (tagFile *const file, const off_t pos)
 {
 	int result = 0;
-	if (fseek (file->fp, pos, SEEK_SET) == 0)
+	if (seekTagFile (file, pos) == 0)
 	{
 		result = readTagLine (file);  /* read probable partial line */
 		if (pos > 0  &&  result)
@@ -790,10 +1151,30 @@ static int readTagLineSeek (tagFile *const file, const off_t pos)
 	return result;
 }
 
+static int hasSubstring (const char *haystack, const char *needle,
+						 size_t length, int ignorecase)
+{
+	if (! ignorecase)
+		return strstr (haystack, needle) != NULL;
+
+	if (length == 0)
+		return 1;
+	for (; *haystack != '\0'; haystack++)
+	{
+		if (tagnuppercmp (needle, haystack, length) == 0)
+			return 1;
+	}
+	return 0;
+}
+
 static int nameComparison (tagFile *const file)
 {
 	int result;
-	if (file->search.ignorecase)
+	if (file->search.substring)
+		result = hasSubstring (file->name.buffer, file->search.name,
+							   file->search.nameLength,
+							   file->search.ignorecase)? 0: 1;
+	else if (file->search.ignorecase)
 	{
 		if (file->search.partial)
 			result = tagnuppercmp (file->search.name, file->name.buffer,
@@ -914,6 +1295,261 @@ static tagResult findSequential (tagFile *const file)
 	return findSequentialFull (file, nameAcceptable, NULL);
 }
 
+static unsigned long long readLittleEndian (const unsigned char *p, int bytes)
+{
+	unsigned long long n = 0;
+	int i;
+	for (i = bytes - 1  ;  i >= 0  ;  --i)
+		n = (n << 8) | p [i];
+	return n;
+}
+
+static unsigned long long mtimeNsecOf (const struct stat *const st)
+{
+#if defined (__APPLE__) && defined (__MACH__)
+	return (unsigned long long) st->st_mtimespec.tv_nsec;
+#elif defined (__unix__)
+	return (unsigned long long) st->st_mtim.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+/* Load the table of TAGFILE.tri if the index is made for the current
+ * contents of the tag file. Posting lists are read when searching. */
+static void loadTrigramIndex (tagFile *const file)
+{
+	const char *const path = file->db? file->db->path: file->path;
+	unsigned char buf [TRIGRAM_HEADER_SIZE];
+	unsigned long i;
+	struct stat st;
+	char *indexPath;
+	FILE *fp;
+
+	file->trigram.loaded = 1;
+	if (path == NULL)
+		return;
+
+	indexPath = malloc (strlen (path) + strlen (TRIGRAM_INDEX_SUFFIX) + 1);
+	if (indexPath == NULL)
+		return;
+	strcpy (indexPath, path);
+	strcat (indexPath, TRIGRAM_INDEX_SUFFIX);
+	fp = fopen (indexPath, "rb");
+	free (indexPath);
+	if (fp == NULL)
+		return;
+	file->trigram.fp = fp;
+
+	if (fread (buf, 1, TRIGRAM_HEADER_SIZE, fp) != TRIGRAM_HEADER_SIZE
+		|| memcmp (buf, TRIGRAM_INDEX_MAGIC, strlen (TRIGRAM_INDEX_MAGIC)) != 0
+		|| readLittleEndian (buf + 8, 4) != TRIGRAM_INDEX_VERSION)
+		goto error;
+
+	/* Ignore the index made for another version of the tag file. */
+	if (stat (path, &st) != 0
+		|| st.st_size != file->size
+		|| (unsigned long long) st.st_size != readLittleEndian (buf + 16, 8)
+		|| (unsigned long long) st.st_mtime != readLittleEndian (buf + 24, 8)
+		|| mtimeNsecOf (&st) != readLittleEndian (buf + 32, 4)
+		|| (unsigned long long) st.st_ino != readLittleEndian (buf + 36, 8))
+		goto error;
+
+	file->trigram.count = (unsigned long) readLittleEndian (buf + 12, 4);
+	if (file->trigram.count == 0)
+		return;
+	file->trigram.table = malloc (file->trigram.count * sizeof (trigramEntry));
+	if (file->trigram.table == NULL)
+		goto error;
+	for (i = 0  ;  i < file->trigram.count  ;  ++i)
+	{
+		if (fread (buf, 1, TRIGRAM_ENTRY_SIZE, fp) != TRIGRAM_ENTRY_SIZE)
+			goto error;
+		file->trigram.table [i].trigram = (unsigned long) readLittleEndian (buf, 4);
+		file->trigram.table [i].count = (unsigned long) readLittleEndian (buf + 4, 4);
+		file->trigram.table [i].offset = (off_t) readLittleEndian (buf + 8, 8);
+	}
+	return;
+
+ error:
+	unloadTrigramIndex (file);
+}
+
+static unsigned long makeTrigram (const char *s)
+{
+	unsigned long trigram = 0;
+	int i;
+	for (i = 0  ;  i < 3  ;  ++i)
+	{
+		unsigned char c = (unsigned char) s [i];
+		if (c >= 'A' && c <= 'Z')
+			c = c - 'A' + 'a';
+		trigram = (trigram << 8) | c;
+	}
+	return trigram;
+}
+
+static const trigramEntry *findTrigram (tagFile *const file, unsigned long trigram)
+{
+	unsigned long lower = 0;
+	unsigned long upper = file->trigram.count;
+	while (lower < upper)
+	{
+		unsigned long middle = lower + (upper - lower) / 2;
+		const trigramEntry *e = file->trigram.table + middle;
+		if (e->trigram == trigram)
+			return e;
+		else if (e->trigram < trigram)
+			lower = middle + 1;
+		else
+			upper = middle;
+	}
+	return NULL;
+}
+
+static int readPosting (FILE *fp, off_t *last)
+{
+	unsigned long long delta = 0;
+	int shift = 0;
+	int c;
+	do
+	{
+		c = getc (fp);
+		if (c == EOF || shift > 63)
+			return 0;
+		delta |= (unsigned long long) (c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	*last += (off_t) delta;
+	return 1;
+}
+
+/* Keep the candidates in the posting list of E. Both are sorted. */
+static int intersectPostings (tagFile *const file, const trigramEntry *e)
+{
+	FILE *const fp = file->trigram.fp;
+	off_t *const candidates = file->search.candidates;
+	const size_t count = file->search.candidateCount;
+	size_t i = 0, n = 0;
+	unsigned long j;
+	off_t pos = 0;
+
+	if (fseek (fp, e->offset, SEEK_SET) != 0)
+		return 0;
+	for (j = 0  ;  j < e->count  &&  i < count  ;  ++j)
+	{
+		if (! readPosting (fp, &pos))
+			return 0;
+		while (i < count  &&  candidates [i] < pos)
+			++i;
+		if (i < count  &&  candidates [i] == pos)
+			candidates [n++] = candidates [i++];
+	}
+	file->search.candidateCount = n;
+	return 1;
+}
+
+/* Collect the lines having all the trigrams of the name searched for.
+ * Returns 0 if the trigram index cannot be used. */
+static int findCandidates (tagFile *const file)
+{
+	const char *const name = file->search.name;
+	const size_t length = file->search.nameLength;
+	const trigramEntry **entries;
+	size_t count = 0;
+	size_t i, j;
+	int result = 0;
+
+	if (length < 3)
+		return 0;
+	if (! file->trigram.loaded)
+		loadTrigramIndex (file);
+	if (file->trigram.fp == NULL)
+		return 0;
+
+	entries = malloc ((length - 2) * sizeof (*entries));
+	if (entries == NULL)
+		return 0;
+
+	for (i = 0  ;  i + 3 <= length  ;  ++i)
+	{
+		const trigramEntry *e = findTrigram (file, makeTrigram (name + i));
+		if (e == NULL)
+		{
+			/* No tag has the trigram. */
+			file->search.candidateCount = 0;
+			result = 1;
+			goto out;
+		}
+		for (j = 0  ;  j < count  &&  entries [j] != e  ;  ++j)
+			;
+		if (j == count)
+			entries [count++] = e;
+	}
+
+	/* Start from the shortest posting list. */
+	for (i = 1  ;  i < count  ;  ++i)
+	{
+		const trigramEntry *e = entries [i];
+		for (j = i  ;  j > 0  &&  entries [j - 1]->count > e->count  ;  --j)
+			entries [j] = entries [j - 1];
+		entries [j] = e;
+	}
+
+	file->search.candidates = malloc (entries [0]->count * sizeof (off_t));
+	if (file->search.candidates == NULL
+		|| fseek (file->trigram.fp, entries [0]->offset, SEEK_SET) != 0)
+		goto out;
+	{
+		off_t pos = 0;
+		for (j = 0  ;  j < entries [0]->count  ;  ++j)
+		{
+			if (! readPosting (file->trigram.fp, &pos))
+				goto out;
+			file->search.candidates [j] = pos;
+		}
+		file->search.candidateCount = entries [0]->count;
+	}
+
+	for (i = 1  ;  i < count  &&  file->search.candidateCount > 0  ;  ++i)
+	{
+		if (! intersectPostings (file, entries [i]))
+			goto out;
+	}
+	result = 1;
+
+ out:
+	free (entries);
+	if (! result)
+	{
+		/* A broken index; fall back to the sequential search. */
+		free (file->search.candidates);
+		file->search.candidates = NULL;
+		file->search.candidateCount = 0;
+		unloadTrigramIndex (file);
+	}
+	return result;
+}
+
+static tagResult findNextCandidate (tagFile *const file, tagEntry *const entry)
+{
+	while (file->search.candidateIndex < file->search.candidateCount)
+	{
+		off_t pos = file->search.candidates [file->search.candidateIndex++];
+		/* Trigrams are case-insensitive, and a name can have all the
+		 * trigrams without having the substring. */
+		if (seekTagFile (file, pos) == 0
+			&& readTagLine (file)
+			&& nameComparison (file) == 0)
+		{
+			if (entry != NULL)
+				parseTagLine (file, entry);
+			return TagSuccess;
+		}
+	}
+	return TagFailure;
+}
+
 static tagResult find (tagFile *const file, tagEntry *const entry,
 					   const char *const name, const int options)
 {
@@ -924,10 +1560,33 @@ static tagResult find (tagFile *const file, tagEntry *const entry,
 	file->search.nameLength = strlen (name);
 	file->search.partial = (options & TAG_PARTIALMATCH) != 0;
 	file->search.ignorecase = (options & TAG_IGNORECASE) != 0;
-	fseek (file->fp, 0, SEEK_END);
-	file->size = ftell (file->fp);
-	rewind (file->fp);
-	if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
+	file->search.substring = (options & TAG_SUBSTRINGMATCH) != 0;
+	free (file->search.candidates);
+	file->search.candidates = NULL;
+	file->search.candidateCount = 0;
+	file->search.candidateIndex = 0;
+	file->search.indexed = 0;
+	file->size = sizeOfTagFile (file);
+	seekTagFile (file, 0);
+	if (file->search.substring)
+	{
+		file->search.indexed = (short) findCandidates (file);
+		if (file->search.indexed)
+		{
+#ifdef DEBUG
+			fputs ("<performing search with trigram index>\n", stderr);
+#endif
+			result = findNextCandidate (file, NULL);
+		}
+		else
+		{
+#ifdef DEBUG
+			fputs ("<performing sequential search>\n", stderr);
+#endif
+			result = findSequential (file);
+		}
+	}
+	else if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
 		(file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase))
 	{
 #ifdef DEBUG
@@ -977,6 +1636,12 @@ static tagResult findNextFull (tagFile *const file, tagEntry *const entry,
 
 static tagResult findNext (tagFile *const file, tagEntry *const entry)
 {
+	if (file->search.substring)
+	{
+		if (file->search.indexed)
+			return findNextCandidate (file, entry);
+		return findNextFull (file, entry, 0, nameAcceptable, NULL);
+	}
 	return findNextFull (file, entry,
 						 (file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
 						 (file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase),
@@ -989,7 +1654,7 @@ static tagResult findPseudoTag (tagFile *const file, int rewindBeforeFinding, ta
 	if (file != NULL  &&  file->initialized)
 	{
 		if (rewindBeforeFinding)
-			rewind (file->fp);
+			seekTagFile (file, 0);
 		result = findNextFull (file, entry,
 							   (file->sortMethod == TAG_SORTED || file->sortMethod == TAG_FOLDSORTED),
 							   doesFilePointPseudoTag,
@@ -1008,6 +1673,40 @@ extern tagFile *tagsOpen (const char *const filePath, tagFileInfo *const info)
 	return initialize (filePath, info);
 }
 
+extern tagDatabase *tagsOpenDatabase (const char *const filePath, tagFileInfo *const info)
+{
+	return initializeDatabase (filePath, info);
+}
+
+extern tagFile *tagsOpenCursor (const tagDatabase *const db, tagFileInfo *const info)
+{
+	tagFile *result = NULL;
+	if (db != NULL)
+		result = openCursor (db);
+	if (info)
+	{
+		if (result)
+			fillInfo (db, info);
+		else
+		{
+			info->status.opened = 0;
+			info->status.error_number = 0;
+		}
+	}
+	return result;
+}
+
+extern tagResult tagsCloseDatabase (tagDatabase *const db)
+{
+	tagResult result = TagFailure;
+	if (db != NULL)
+	{
+		terminateDatabase (db);
+		result = TagSuccess;
+	}
+	return result;
+}
+
 extern tagResult tagsSetSortType (tagFile *const file, const sortType type)
 {
 	tagResult result = TagFailure;
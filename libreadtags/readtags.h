@@ -39,6 +39,8 @@ typedef enum {
 #define TAG_OBSERVECASE   0x0
 #define TAG_IGNORECASE    0x2
 
+#define TAG_SUBSTRINGMATCH 0x4
+
 /*
 *  DATA DECLARATIONS
 */
@@ -49,6 +51,10 @@ struct sTagFile;
 
 typedef struct sTagFile tagFile;
 
+struct sTagDatabase;
+
+typedef struct sTagDatabase tagDatabase;
+
 /* This structure contains information about the tag file. */
 typedef struct {
 
@@ -158,6 +164,35 @@ typedef struct {
 */
 extern tagFile *tagsOpen (const char *const filePath, tagFileInfo *const info);
 
+/*
+*  Open a tag file as a tag database shared by cursors. The contents of the
+*  tag file are mapped read-only (or read to memory on platforms without
+*  mmap()), and the pseudo tags are parsed once here. `info' is populated as
+*  tagsOpen() does. The strings in info.program are owned by the database.
+*
+*  A tag database is never modified after this function returns. Cursors
+*  made from one database with tagsOpenCursor() can be used in different
+*  threads at the same time without locking. A cursor itself must not be used
+*  in two threads at the same time.
+*/
+extern tagDatabase *tagsOpenDatabase (const char *const filePath, tagFileInfo *const info);
+
+/*
+*  Make a cursor for reading a tag database. A cursor is a tag file handle
+*  with its own read position, line buffers and search state; it can be
+*  passed to all functions taking a handle returned from tagsOpen(). Creating
+*  a cursor doesn't read the tag file. Close the cursor with tagsClose().
+*  If `info' is not null, it is populated as tagsOpenDatabase() does.
+*/
+extern tagFile *tagsOpenCursor (const tagDatabase *const db, tagFileInfo *const info);
+
+/*
+*  Free a tag database. All cursors made from the database must be closed
+*  before calling this function. The function will return TagFailure if `db'
+*  is null, TagSuccess otherwise.
+*/
+extern tagResult tagsCloseDatabase (tagDatabase *const db);
+
 /*
 *  This function allows the client to override the normal automatic detection
 *  of how a tag file is sorted. Permissible values for `type' are
@@ -223,6 +258,15 @@ extern const char *tagsField (const tagEntry *const entry, const char *const key
 *        Matching will be performed in a case-sensitive manner. Note that
 *        this enables binary searches of the tag file.
 *
+*    TAG_SUBSTRINGMATCH
+*        Tags whose names include `name' will qualify. If the trigram index
+*        made with "ctags --trigram-index" exists for the tag file as
+*        "<tagfile>.tri" and `name' has three characters or more, only the
+*        tag lines having all the trigrams of `name' are read. Otherwise, the
+*        tag file is searched sequentially. Stale indexes are ignored. This
+*        overrides TAG_PARTIALMATCH, and can be combined with TAG_IGNORECASE.
+*        Matching tags are returned in the order of the tag file.
+*
 *  The function will return TagSuccess if a tag matching the name is found, or
 *  TagFailure if not.
 */
@@ -0,0 +1,281 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released into the public domain.
+*
+*   Testing tagsOpenDatabase(), tagsOpenCursor() and tagsCloseDatabase() API
+*   functions
+*/
+
+#include "readtags.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define COUNT(x) (sizeof(x)/sizeof(x[0]))
+
+static int
+same_string (const char *a, const char *b)
+{
+	if (a == NULL || b == NULL)
+		return a == b;
+	return strcmp (a, b) == 0;
+}
+
+static int
+same_entry (const tagEntry *a, const tagEntry *b)
+{
+	if (!(same_string (a->name, b->name)
+		  && same_string (a->file, b->file)
+		  && same_string (a->address.pattern, b->address.pattern)
+		  && a->address.lineNumber == b->address.lineNumber
+		  && same_string (a->kind, b->kind)
+		  && a->fileScope == b->fileScope
+		  && a->fields.count == b->fields.count))
+		return 0;
+
+	for (unsigned short i = 0; i < a->fields.count; i++)
+	{
+		if (!(same_string (a->fields.list[i].key, b->fields.list[i].key)
+			  && same_string (a->fields.list[i].value, b->fields.list[i].value)))
+			return 0;
+	}
+	return 1;
+}
+
+static int
+same_info (const tagFileInfo *a, const tagFileInfo *b)
+{
+	return a->status.opened == b->status.opened
+		&& a->file.format == b->file.format
+		&& a->file.sort == b->file.sort
+		&& same_string (a->program.author, b->program.author)
+		&& same_string (a->program.name, b->program.name)
+		&& same_string (a->program.url, b->program.url)
+		&& same_string (a->program.version, b->program.version);
+}
+
+/* Compare the results of iterating on FILE and on CURSOR. While iterating,
+ * OTHER, another cursor of the same database, is moved to check that it
+ * doesn't disturb CURSOR. */
+static int
+check_walking (const char *what, tagFile *file, tagFile *cursor, tagFile *other,
+			   tagResult (* first) (tagFile *const, tagEntry *const),
+			   tagResult (* next) (tagFile *const, tagEntry *const))
+{
+	tagEntry e0, e1, e2;
+	tagResult r0, r1;
+	int n = 0;
+
+	fprintf (stderr, "walking %s...", what);
+	r0 = first (file, &e0);
+	r1 = first (cursor, &e1);
+	first (other, &e2);
+	while (1)
+	{
+		if (r0 != r1)
+		{
+			fprintf (stderr, "unexpected result at %d (tagsOpen: %d, cursor: %d)\n",
+					 n, r0, r1);
+			return 1;
+		}
+		if (r0 != TagSuccess)
+			break;
+		if (!same_entry (&e0, &e1))
+		{
+			fprintf (stderr, "unexpected entry at %d: %s\n", n, e1.name);
+			return 1;
+		}
+		n++;
+
+		r0 = next (file, &e0);
+		next (other, &e2);
+		r1 = next (cursor, &e1);
+	}
+	fprintf (stderr, "ok (%d entries)\n", n);
+	return 0;
+}
+
+static int
+check_finding (tagFile *file, tagFile *cursor, tagFile *other,
+			   const char *name, const int options)
+{
+	tagEntry e0, e1, e2;
+	tagResult r0, r1;
+	int n = 0;
+
+	fprintf (stderr, "finding \"%s\" (%d)...", name, options);
+	r0 = tagsFind (file, &e0, name, options);
+	r1 = tagsFind (cursor, &e1, name, options);
+	/* Searching another name with the other cursor must not change
+	 * the search state of CURSOR. */
+	tagsFind (other, &e2, "M", TAG_IGNORECASE);
+	while (1)
+	{
+		if (r0 != r1)
+		{
+			fprintf (stderr, "unexpected result at %d (tagsOpen: %d, cursor: %d)\n",
+					 n, r0, r1);
+			return 1;
+		}
+		if (r0 != TagSuccess)
+			break;
+		if (!same_entry (&e0, &e1))
+		{
+			fprintf (stderr, "unexpected entry at %d: %s\n", n, e1.name);
+			return 1;
+		}
+		n++;
+
+		r0 = tagsFindNext (file, &e0);
+		tagsFindNext (other, &e2);
+		r1 = tagsFindNext (cursor, &e1);
+	}
+	fprintf (stderr, "ok (%d entries)\n", n);
+	return 0;
+}
+
+static int
+check_database (const char *tags)
+{
+	tagFile *t, *c0, *c1;
+	tagDatabase *db;
+	tagFileInfo info, db_info, cursor_info;
+	const char *names [] = { "n", "M", "m", "main", "N", "O", "no-such-tag" };
+	const int options [] = {
+		TAG_FULLMATCH | TAG_OBSERVECASE,
+		TAG_PARTIALMATCH | TAG_OBSERVECASE,
+		TAG_FULLMATCH | TAG_IGNORECASE,
+		TAG_PARTIALMATCH | TAG_IGNORECASE,
+	};
+
+	fprintf (stderr, "opening %s...", tags);
+	t = tagsOpen (tags, &info);
+	if (!t)
+	{
+		fprintf (stderr, "unexpected result (t: %p, opened: %d, error_number: %d)\n",
+				 t, info.status.opened, info.status.error_number);
+		return 1;
+	}
+	fprintf (stderr, "ok\n");
+
+	fprintf (stderr, "opening %s as a database...", tags);
+	db = tagsOpenDatabase (tags, &db_info);
+	if (!db)
+	{
+		fprintf (stderr, "unexpected result (db: %p, opened: %d, error_number: %d)\n",
+				 db, db_info.status.opened, db_info.status.error_number);
+		return 1;
+	}
+	fprintf (stderr, "ok\n");
+
+	fprintf (stderr, "checking info of the database...");
+	if (!same_info (&info, &db_info))
+	{
+		fprintf (stderr, "unexpected\n");
+		return 1;
+	}
+	fprintf (stderr, "ok\n");
+
+	fprintf (stderr, "opening cursors...");
+	c0 = tagsOpenCursor (db, &cursor_info);
+	c1 = tagsOpenCursor (db, NULL);
+	if (!c0 || !c1)
+	{
+		fprintf (stderr, "unexpected result (c0: %p, c1: %p)\n", c0, c1);
+		return 1;
+	}
+	fprintf (stderr, "ok\n");
+
+	fprintf (stderr, "checking info of the cursor...");
+	if (!same_info (&info, &cursor_info))
+	{
+		fprintf (stderr, "unexpected\n");
+		return 1;
+	}
+	fprintf (stderr, "ok\n");
+
+	/* The first tag can be read with tagsNext() right after opening. */
+	if (check_walking ("tags with tagsNext", t, c0, c1, tagsNext, tagsNext) != 0)
+		return 1;
+	if (check_walking ("tags", t, c0, c1, tagsFirst, tagsNext) != 0)
+		return 1;
+	if (check_walking ("pseudo tags", t, c0, c1,
+					   tagsFirstPseudoTag, tagsNextPseudoTag) != 0)
+		return 1;
+
+	for (size_t i = 0; i < COUNT(names); i++)
+	{
+		for (size_t j = 0; j < COUNT(options); j++)
+		{
+			if (check_finding (t, c0, c1, names[i], options[j]) != 0)
+				return 1;
+		}
+	}
+
+	fprintf (stderr, "closing the tag file and cursors...");
+	if (tagsClose (t) != TagSuccess
+		|| tagsClose (c0) != TagSuccess
+		|| tagsClose (c1) != TagSuccess)
+	{
+		fprintf (stderr, "unexpected result\n");
+		return 1;
+	}
+	fprintf (stderr, "ok\n");
+
+	fprintf (stderr, "closing the database...");
+	if (tagsCloseDatabase (db) != TagSuccess)
+	{
+		fprintf (stderr, "unexpected result\n");
+		return 1;
+	}
+	fprintf (stderr, "ok\n");
+
+	return 0;
+}
+
+int
+main (void)
+{
+	char *srcdir = getenv ("srcdir");
+	if (srcdir)
+	{
+		if (chdir (srcdir) == -1)
+		{
+			perror ("chdir");
+			return 99;
+		}
+	}
+
+	const char *tags [] = {
+		"./duplicated-names--sorted-yes.tags",
+		"./duplicated-names--sorted-no.tags",
+		"./duplicated-names--sorted-foldcase.tags",
+		"./ptag-sort-yes.tags",
+		"./ptag-sort-no.tags",
+		"./api-tagsOpen-ectags.tags",
+	};
+
+	for (size_t i = 0; i < COUNT(tags); i++)
+	{
+		if (check_database (tags[i]) != 0)
+			return 1;
+	}
+
+	tagFileInfo info;
+	fprintf (stderr, "opening a non-existing tag file as a database...");
+	if (tagsOpenDatabase ("./no-such-file.tags", &info) != NULL
+		|| info.status.opened
+		|| info.status.error_number == 0)
+	{
+		fprintf (stderr, "unexpected result (opened: %d, error_number: %d)\n",
+				 info.status.opened, info.status.error_number);
+		return 1;
+	}
+	fprintf (stderr, "ok\n");
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Per input file budgets (--max-file-size, --max-parse-time,
+*   --max-tags-per-file)
+*
+*   The budgets are enforced cooperatively. The input layer charges the
+*   bytes it reads, and makeTagEntry () charges the tags it makes. When
+*   a budget is exceeded, the input layer returns EOF so that the parser
+*   finishes soon, and the tags made for the file are discarded with
+*   the same way as RESCAN_FAILED. Nesting depth is not limited here;
+*   it is specific to each parser.
+*
+*   The parse time is checked on both charges. The parsers taking the
+*   whole input with getInputFileData () instead of reading lines, like
+*   the libxml2 based ones, are covered only through their tags.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <time.h>
+
+#include "budget_p.h"
+#include "options_p.h"
+#include "routines.h"
+#include "routines_p.h"
+
+/*
+*   MACROS
+*/
+/* The parse time is checked after reading this many bytes. A line is
+ * charged a few bytes more than its length so that files of short
+ * lines are checked as often. A tag is charged as some bytes. */
+#define TIME_CHECK_INTERVAL  (64 * 1024)
+#define LINE_CHARGE          16
+#define TAG_CHARGE           256
+
+/*
+*   DATA DEFINITIONS
+*/
+static struct {
+	const char *fileName;
+	clock_t start;
+	size_t uncheckedBytes;
+	unsigned long tags;
+	bool exceeded;
+} Budget;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+extern bool isInputFileTooLarge (const char *const fileName, MIO *mio)
+{
+	size_t size;
+	bool r;
+
+	if (Option.maxFileSize == 0)
+		return false;
+
+	if (mio && mio_memory_get_data (mio, &size))
+		r = (size > Option.maxFileSize);
+	else
+	{
+		fileStatus *status = eStat (fileName);
+		r = (status->exists && (unsigned long) status->size > Option.maxFileSize);
+		eStatFree (status);
+	}
+
+	if (r)
+		error (WARNING, "%s: skipped: larger than %lu bytes (--max-file-size)",
+			   fileName, Option.maxFileSize);
+	return r;
+}
+
+extern void resetInputBudget (const char *const fileName)
+{
+	Budget.fileName = fileName;
+	Budget.start = Option.maxParseTime? clock (): 0;
+	Budget.uncheckedBytes = 0;
+	Budget.tags = 0;
+	Budget.exceeded = false;
+}
+
+static void exceedInputBudget (const char *const what, unsigned long limit)
+{
+	Budget.exceeded = true;
+	error (WARNING, "%s: aborted parsing: more than %lu %s",
+		   Budget.fileName, limit, what);
+}
+
+static void chargeParseTime (size_t length)
+{
+	if (Option.maxParseTime == 0 || Budget.exceeded)
+		return;
+
+	Budget.uncheckedBytes += length;
+	if (Budget.uncheckedBytes < TIME_CHECK_INTERVAL)
+		return;
+	Budget.uncheckedBytes = 0;
+
+	if ((clock () - Budget.start) / CLOCKS_PER_SEC >= Option.maxParseTime)
+		exceedInputBudget ("seconds (--max-parse-time)", Option.maxParseTime);
+}
+
+extern void chargeInputBudgetForInput (size_t length)
+{
+	chargeParseTime (length + LINE_CHARGE);
+}
+
+extern void chargeInputBudgetForTag (void)
+{
+	chargeParseTime (TAG_CHARGE);
+
+	if (Option.maxTagsPerFile == 0 || Budget.exceeded)
+		return;
+
+	if (++Budget.tags > Option.maxTagsPerFile)
+		exceedInputBudget ("tags (--max-tags-per-file)", Option.maxTagsPerFile);
+}
+
+extern bool isInputBudgetExceeded (void)
+{
+	return Budget.exceeded;
+}
@@ -0,0 +1,42 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Per input file budgets (--max-file-size, --max-parse-time,
+*   --max-tags-per-file)
+*/
+#ifndef CTAGS_MAIN_BUDGET_PRIVATE_H
+#define CTAGS_MAIN_BUDGET_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "mio.h"
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* Return true if the input file is larger than --max-file-size.
+ * If MIO is NULL, the size is taken with FILENAME. */
+extern bool isInputFileTooLarge (const char *const fileName, MIO *mio);
+
+/* Start the budget for parsing an input file. */
+extern void resetInputBudget (const char *const fileName);
+
+/* Charge LENGTH bytes read from the input file. */
+extern void chargeInputBudgetForInput (size_t length);
+
+/* Charge a tag made for the input file. The parse time is checked
+ * here too for the parsers not reading the input by lines. */
+extern void chargeInputBudgetForTag (void);
+
+/* Once the budget is exceeded, the input layer returns EOF, and
+ * no more tags are made for the file. */
+extern bool isInputBudgetExceeded (void);
+
+#endif	/* CTAGS_MAIN_BUDGET_PRIVATE_H */
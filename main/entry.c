@@ -46,7 +46,9 @@
 #include "kind.h"
 #include "nestlevel.h"
 #include "options_p.h"
+#include "budget_p.h"
 #include "ptag_p.h"
+#include "probe_p.h"
 #include "rbtree.h"
 #include "read.h"
 #include "read_p.h"
@@ -58,6 +60,8 @@
 #include "strlist.h"
 #include "subparser_p.h"
 #include "trashbox.h"
+#include "refs_p.h"
+#include "trigram_p.h"
 #include "writer_p.h"
 #include "xtag_p.h"
 
@@ -104,6 +108,8 @@ typedef struct sTagEntryInfoX  {
 	int corkIndex;
 	struct rb_root symtab;
 	struct rb_node symnode;
+	char *fqName;				/* cache for the children */
+	bool borrowingScopeName;	/* scopeName is the fqName of the scope entry */
 } tagEntryInfoX;
 
 /*
@@ -123,6 +129,9 @@ static tagFile TagFile = {
 };
 
 static bool TagsToStdout = false;
+/* Unsorted tags to stdout are kept in memory only until the input
+ * file is done, then written out with flushTagFile(). */
+static bool TagsStreamed = false;
 
 /*
 *   FUNCTION PROTOTYPES
@@ -389,9 +398,11 @@ extern void openTagFile (void)
 
 	/*  Open the tags file.
 	 */
+	TagsStreamed = TagsToStdout && Option.sorted == SO_UNSORTED;
+
 	if (TagsToStdout)
 	{
-		if (Option.interactive == INTERACTIVE_SANDBOX)
+		if (Option.interactive == INTERACTIVE_SANDBOX || TagsStreamed)
 		{
 			TagFile.mio = mio_new_memory (NULL, 0, eRealloc, eFreeNoNullCheck);
 			TagFile.name = NULL;
@@ -544,14 +555,14 @@ static void sortTagFile (void)
 		if (Option.sorted != SO_UNSORTED)
 		{
 			verbose ("sorting tag file\n");
+			PROBE1 (sort__start, TagFile.numTags.added + TagFile.numTags.prev);
 #ifdef EXTERNAL_SORT
 			externalSortTags (TagsToStdout, TagFile.mio);
 #else
 			internalSortTagFile ();
 #endif
+			PROBE1 (sort__end, TagFile.numTags.added + TagFile.numTags.prev);
 		}
-		else if (TagsToStdout)
-			catFile (TagFile.mio);
 	}
 }
 
@@ -614,6 +625,8 @@ extern void closeTagFile (const bool resize)
 	mio_flush (TagFile.mio);
 
 	abort_if_ferror (TagFile.mio);
+	if (TagsStreamed)
+		flushTagFile ();
 	desiredSize = mio_tell (TagFile.mio);
 	mio_seek (TagFile.mio, 0L, SEEK_END);
 	size = mio_tell (TagFile.mio);
@@ -630,6 +643,12 @@ extern void closeTagFile (const bool resize)
 		resizeTagFile (desiredSize);
 	}
 	sortTagFile ();
+	if (Option.trigramIndex && ! TagsToStdout)
+	{
+		writerType type = getTagWriterType ();
+		if (type == WRITER_U_CTAGS || type == WRITER_E_CTAGS)
+			writeTrigramIndex (TagFile.name);
+	}
 	if (TagsToStdout)
 	{
 		if (mio_unref (TagFile.mio) != 0)
@@ -753,54 +772,70 @@ extern size_t truncateTagLineAfterTag (
 	return len;
 }
 
-static char* getFullQualifiedScopeNameFromCorkQueue (const tagEntryInfo * inner_scope)
+/* The full qualified name of an entry in the cork queue is cached in
+ * the entry, and built from the cached name of its parent. Children of
+ * the entry refer to the cached name as their scope name. */
+static const char* getFullQualifiedScopeNameFromCorkQueue (const tagEntryInfo * inner_scope)
 {
-
-	int kindIndex = KIND_GHOST_INDEX;
-	langType lang;
 	const tagEntryInfo *scope = inner_scope;
-	const tagEntryInfo *root_scope = NULL;
-	stringList *queue = stringListNew ();
-	vString *v;
-	vString *n;
-	unsigned int c;
-	const char *sep;
-
+	tagEntryInfoX *target;
+	tagEntryInfoX *x;
+	ptrArray *uncached;
+
+	while (scope && scope->placeholder)
+		scope = getEntryInCorkQueue (scope->extensionFields.scopeIndex);
+	if (scope == NULL)
+		return "";
+
+	target = (tagEntryInfoX *)scope;
+	if (target->fqName)
+		return target->fqName;
+
+	/* Collect the entries whose names are not cached yet, from inner
+	 * to outer. */
+	uncached = ptrArrayNew (NULL);
 	while (scope)
 	{
+		x = (tagEntryInfoX *)scope;
 		if (!scope->placeholder)
 		{
-			if (kindIndex != KIND_GHOST_INDEX)
-			{
-				sep = scopeSeparatorFor (lang, kindIndex, scope->kindIndex);
-				v = vStringNewInit (sep);
-				stringListAdd (queue, v);
-			}
-			/* TODO: scope field of SCOPE can be used for optimization. */
-			v = vStringNewInit (scope->name);
-			stringListAdd (queue, v);
-			kindIndex = scope->kindIndex;
-			lang = scope->langType;
-			root_scope = scope;
+			if (x->fqName)
+				break;
+			ptrArrayAdd (uncached, x);
 		}
-		scope =  getEntryInCorkQueue (scope->extensionFields.scopeIndex);
+		scope = getEntryInCorkQueue (scope->extensionFields.scopeIndex);
 	}
 
-	n = vStringNew ();
-	sep = root_scope? scopeSeparatorFor (root_scope->langType, root_scope->kindIndex, KIND_GHOST_INDEX): NULL;
-	if (sep)
-		vStringCatS(n, sep);
-
-	while ((c = stringListCount (queue)) > 0)
+	/* Fill the caches from outer to inner. */
+	const tagEntryInfo *outer = scope;
+	while (ptrArrayCount (uncached) > 0)
 	{
-		v = stringListLast (queue);
-		vStringCat (n, v);
-		vStringDelete (v);
-		stringListRemoveLast (queue);
+		vString *n = vStringNew ();
+		const char *sep;
+
+		x = ptrArrayLast (uncached);
+		scope = &x->slot;
+		if (outer)
+		{
+			vStringCatS (n, ((tagEntryInfoX *)outer)->fqName);
+			sep = scopeSeparatorFor (scope->langType, scope->kindIndex, outer->kindIndex);
+			vStringCatS (n, sep);
+		}
+		else
+		{
+			sep = scopeSeparatorFor (scope->langType, scope->kindIndex, KIND_GHOST_INDEX);
+			if (sep)
+				vStringCatS (n, sep);
+		}
+		vStringCatS (n, scope->name);
+		x->fqName = vStringDeleteUnwrap (n);
+
+		outer = scope;
+		ptrArrayRemoveLast (uncached);
 	}
-	stringListDelete (queue);
+	ptrArrayDelete (uncached);
 
-	return vStringDeleteUnwrap (n);
+	return target->fqName;
 }
 
 extern void getTagScopeInformation (tagEntryInfo *const tag,
@@ -817,13 +852,16 @@ extern void getTagScopeInformation (tagEntryInfo *const tag,
 	    && scope
 	    && ptrArrayCount (TagFile.corkQueue) > 0)
 	{
-		char *full_qualified_scope_name = getFullQualifiedScopeNameFromCorkQueue(scope);
+		const char *full_qualified_scope_name = getFullQualifiedScopeNameFromCorkQueue(scope);
 		Assert (full_qualified_scope_name);
 
-		/* Make the information reusable to generate full qualified entry, and xformat output*/
+		/* Make the information reusable to generate full qualified entry, and xformat output.
+		 * TAG must be in the cork queue because it has a scope in the queue.
+		 * TAG borrows the name owned by the scope entry. */
 		tag->extensionFields.scopeLangType = scope->langType;
 		tag->extensionFields.scopeKindIndex = scope->kindIndex;
 		tag->extensionFields.scopeName = full_qualified_scope_name;
+		((tagEntryInfoX *)tag)->borrowingScopeName = true;
 	}
 
 	if (tag->extensionFields.scopeKindIndex != KIND_GHOST_INDEX  &&
@@ -1058,6 +1096,8 @@ static tagEntryInfoX *copyTagEntry (const tagEntryInfo *const tag,
 	tagEntryInfoX *x = xMalloc (1, tagEntryInfoX);
 	x->symtab = RB_ROOT;
 	x->corkIndex = CORK_NIL;
+	x->fqName = NULL;
+	x->borrowingScopeName = false;
 	tagEntryInfo  *slot = (tagEntryInfo *)x;
 
 	*slot = *tag;
@@ -1133,6 +1173,7 @@ static void clearParserFields (tagEntryInfo *const tag)
 
 static void deleteTagEnry (void *data)
 {
+	tagEntryInfoX *x = data;
 	tagEntryInfo *slot = data;
 
 	if (slot->kindIndex == KIND_FILE_INDEX)
@@ -1149,7 +1190,7 @@ static void deleteTagEnry (void *data)
 		eFree ((char *)slot->extensionFields.implementation);
 	if (slot->extensionFields.inheritance)
 		eFree ((char *)slot->extensionFields.inheritance);
-	if (slot->extensionFields.scopeName)
+	if (slot->extensionFields.scopeName && !x->borrowingScopeName)
 		eFree ((char *)slot->extensionFields.scopeName);
 	if (slot->extensionFields.signature)
 		eFree ((char *)slot->extensionFields.signature);
@@ -1171,6 +1212,8 @@ static void deleteTagEnry (void *data)
 	clearParserFields (slot);
 
  out:
+	if (x->fqName)
+		eFree (x->fqName);
 	eFree (slot);
 }
 
@@ -1528,6 +1571,12 @@ static void writeTagEntry (const tagEntryInfo *const tag)
 
 	DebugStatement ( debugEntry (tag); )
 
+	if (tag->extensionFields.roleBits && isReferenceOutputEnabled ())
+	{
+		addReferenceOccurrence (tag);
+		return;
+	}
+
 #ifdef WIN32
 	if (getFilenameSeparator(Option.useSlashAsFilenameSeparator) == FILENAME_SEP_USE_SLASH)
 	{
@@ -1552,6 +1601,7 @@ static void writeTagEntry (const tagEntryInfo *const tag)
 		buildFqTagCache ( (tagEntryInfo *const)tag);
 	}
 
+	PROBE3 (tag__write, tag->name, tag->inputFileName, tag->lineNumber);
 	length = writerWriteTag (TagFile.mio, tag);
 
 	if (length > 0)
@@ -1689,6 +1739,10 @@ extern int makeTagEntry (const tagEntryInfo *const tag)
 		goto out;
 	}
 
+	if (isInputBudgetExceeded ())
+		goto out;
+	chargeInputBudgetForTag ();
+
 	if (TagFile.cork)
 		r = queueTagEntry (tag);
 	else
@@ -1973,6 +2027,54 @@ extern bool isRoleAssigned(const tagEntryInfo *const e, int roleIndex)
 		return (e->extensionFields.roleBits & makeRoleBit(roleIndex));
 }
 
+extern MIO *divertTagFile (MIO *mio)
+{
+	MIO *orig = TagFile.mio;
+
+	TagFile.mio = mio;
+	return orig;
+}
+
+extern void appendToTagFile (const unsigned char *data, size_t length)
+{
+	const unsigned char *p = data;
+	const unsigned char *const end = data + length;
+
+	while (p < end)
+	{
+		const unsigned char *nl = memchr (p, '\n', end - p);
+		size_t lineLength = (nl? nl + 1: end) - p;
+
+		rememberMaxLengths (0, lineLength);
+		p += lineLength;
+	}
+
+	mio_write (TagFile.mio, data, 1, length);
+	abort_if_ferror (TagFile.mio);
+}
+
+extern void flushTagFile (void)
+{
+	long length;
+
+	if (!TagsStreamed || TagFile.mio == NULL)
+		return;
+
+	length = mio_tell (TagFile.mio);
+	if (length > 0)
+	{
+		unsigned char *data = mio_memory_get_data (TagFile.mio, NULL);
+
+		if (fwrite (data, 1, length, stdout) != (size_t) length
+			|| fflush (stdout) == EOF)
+			error (FATAL | PERROR, "cannot write tags to stdout");
+	}
+
+	/* The buffer is reused for the next input file. The data after
+	 * the position is left by rescanning; it is never written out. */
+	mio_seek (TagFile.mio, 0L, SEEK_SET);
+}
+
 extern unsigned long numTagsAdded(void)
 {
 	return TagFile.numTags.added;
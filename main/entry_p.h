@@ -30,6 +30,9 @@ extern void freeTagFileResources (void);
 extern const char *tagFileName (void);
 extern void openTagFile (void);
 extern void closeTagFile (const bool resize);
+/* Write out the tags for the input file just parsed if they go to
+ * stdout without sorting. */
+extern void flushTagFile (void);
 extern void  setupWriter (void *writerClientData);
 extern bool  teardownWriter (const char *inputFilename);
 
@@ -39,6 +42,11 @@ extern unsigned long numTagsTotal(void);
 extern unsigned long maxTagsLine(void);
 extern void invalidatePatternCache(void);
 extern void tagFilePosition (MIOPos *p);
+
+/* Redirect the output for the tag file to MIO. The original MIO is
+ * returned. */
+extern MIO *divertTagFile (MIO *mio);
+extern void appendToTagFile (const unsigned char *data, size_t length);
 extern void setTagFilePosition (MIOPos *p);
 extern const char* getTagFileDirectory (void);
 extern void getTagScopeInformation (tagEntryInfo *const tag,
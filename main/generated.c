@@ -0,0 +1,156 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Detecting minified or generated input files (--generated-files)
+*
+*   Minified bundles, lock files, and machine generated sources give
+*   many useless tags, and take long to parse. Such a file is guessed
+*   cheaply from the head of the file:
+*
+*   - the name of a well known lock file,
+*   - a marker of generated code like "@generated" or "DO NOT EDIT"
+*     near the beginning, or
+*   - long lines with few white spaces, as minified code has.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+
+#include "generated_p.h"
+#include "options.h"
+#include "routines.h"
+
+/*
+*   MACROS
+*/
+#define SAMPLE_SIZE                 (16 * 1024)
+#define MARKER_AREA_SIZE            1024
+
+/* Minified code is guessed with the sample at least this long, when
+ * the average length of lines is at least MINIFIED_LINE_LENGTH, and
+ * white spaces are less than MINIFIED_SPACE_PERCENT of the sample. */
+#define MINIFIED_MIN_SAMPLE_SIZE    1024
+#define MINIFIED_LINE_LENGTH        256
+#define MINIFIED_SPACE_PERCENT      15
+
+/*
+*   DATA DEFINITIONS
+*/
+static const char *const LockFileNames [] = {
+	"Cargo.lock",
+	"Gemfile.lock",
+	"composer.lock",
+	"npm-shrinkwrap.json",
+	"package-lock.json",
+	"pnpm-lock.yaml",
+	"poetry.lock",
+	"yarn.lock",
+};
+
+static const char *const GeneratedMarkers [] = {
+	"@generated",
+	"DO NOT EDIT",
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static bool isLockFile (const char *const fileName)
+{
+	const char *const base = baseFilename (fileName);
+
+	for (unsigned int i = 0; i < ARRAY_SIZE (LockFileNames); i++)
+		if (strcmp (base, LockFileNames [i]) == 0)
+			return true;
+	return false;
+}
+
+static size_t readSample (const char *const fileName, MIO *mio,
+						  char *buf, size_t size)
+{
+	size_t length;
+
+	if (mio)
+	{
+		long pos = mio_tell (mio);
+
+		mio_rewind (mio);
+		length = mio_read (mio, buf, 1, size);
+		mio_seek (mio, pos, SEEK_SET);
+	}
+	else
+	{
+		MIO *fmio = mio_new_file (fileName, "rb");
+
+		if (fmio == NULL)
+			return 0;
+		length = mio_read (fmio, buf, 1, size);
+		mio_unref (fmio);
+	}
+	return length;
+}
+
+static bool hasGeneratedMarker (const char *const sample, size_t length)
+{
+	char head [MARKER_AREA_SIZE + 1];
+
+	if (length > MARKER_AREA_SIZE)
+		length = MARKER_AREA_SIZE;
+	memcpy (head, sample, length);
+	head [length] = '\0';
+
+	for (unsigned int i = 0; i < ARRAY_SIZE (GeneratedMarkers); i++)
+		if (strstr (head, GeneratedMarkers [i]))
+			return true;
+	return false;
+}
+
+static bool looksMinified (const char *const sample, size_t length)
+{
+	size_t lines = 1;
+	size_t spaces = 0;
+
+	if (length < MINIFIED_MIN_SAMPLE_SIZE)
+		return false;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		if (sample [i] == '\n')
+			lines++;
+		else if (sample [i] == ' ' || sample [i] == '\t')
+			spaces++;
+	}
+
+	return (length / lines >= MINIFIED_LINE_LENGTH
+			&& spaces * 100 < length * MINIFIED_SPACE_PERCENT);
+}
+
+extern bool isGeneratedFile (const char *const fileName, MIO *mio)
+{
+	static char sample [SAMPLE_SIZE];
+	size_t length;
+	const char *reason = NULL;
+
+	if (isLockFile (fileName))
+		reason = "lock";
+	else
+	{
+		length = readSample (fileName, mio, sample, sizeof (sample));
+		if (hasGeneratedMarker (sample, length))
+			reason = "generated";
+		else if (looksMinified (sample, length))
+			reason = "minified";
+	}
+
+	if (reason)
+		verbose ("%s: looks like a %s file\n", fileName, reason);
+	return reason != NULL;
+}
@@ -0,0 +1,28 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Detecting minified or generated input files (--generated-files)
+*/
+#ifndef CTAGS_MAIN_GENERATED_PRIVATE_H
+#define CTAGS_MAIN_GENERATED_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "mio.h"
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* Return true if the input file looks minified or generated. Only the
+ * head of the file is examined. If MIO is NULL, the file is opened with
+ * FILENAME. */
+extern bool isGeneratedFile (const char *const fileName, MIO *mio);
+
+#endif	/* CTAGS_MAIN_GENERATED_PRIVATE_H */
@@ -23,6 +23,9 @@
 #ifndef xMalloc
 #define xMalloc(n,Type)    (Type *)malloc((size_t)(n) * sizeof (Type))
 #endif
+#ifndef eMalloc
+#define eMalloc(n) malloc(n)
+#endif
 #ifndef eFree
 #define eFree(x) free(x)
 #endif
@@ -31,6 +34,16 @@
 #include <string.h>
 
 
+/* The table is an open addressing table with linear probing and the
+ * Robin Hood displacement rule.  A slot holds the cached hash value of
+ * a key and the chain of items put for the key; the newest item comes
+ * first in the chain.  Slots are moved around when the table grows or
+ * an item is deleted; the items are not.
+ *
+ * Items are allocated from chunks owned by the table instead of being
+ * malloc'ed one by one.  An item released by hashTableDeleteItem() or
+ * hashTableUpdateItem() is recycled via a free list. */
+
 typedef struct sHashEntry hentry;
 struct sHashEntry {
 	void *key;
@@ -38,29 +51,104 @@ struct sHashEntry {
 	hentry *next;
 };
 
-struct sHashTable {
-	hentry** table;
+typedef struct sHashSlot hslot;
+struct sHashSlot {
+	hentry *chain;				/* NULL means the slot is empty. */
+	unsigned int hash;
+};
+
+typedef struct sHashEntryChunk hchunk;
+struct sHashEntryChunk {
+	hchunk *next;
 	unsigned int size;
+	unsigned int used;
+	hentry entries[];
+};
+
+struct sHashTable {
+	hslot* table;
+	unsigned int size;			/* always power of 2 */
+	unsigned int nkeys;			/* the number of occupied slots */
+	unsigned int nitems;
+	bool frozen;
+
+	hchunk *chunks;
+	hentry *freeEntries;
+
 	hashTableHashFunc hashfn;
 	hashTableEqualFunc equalfn;
 	hashTableDeleteFunc keyfreefn;
 	hashTableDeleteFunc valfreefn;
 };
 
-struct chainTracker {
-	const void *const target_key;
-	hashTableForeachFunc user_proc;
-	void *user_data;
-	hashTableEqualFunc equalfn;
-};
+#define HTABLE_MIN_SIZE   8
+#define HTABLE_CHUNK_MIN  16
+#define HTABLE_CHUNK_MAX  4096
 
-static hentry* entry_new (void *key, void *value, hentry* next)
+/* Keep the load factor under 3/4. */
+#define HTABLE_FULL(N,SIZE) (((N) * 4) >= ((SIZE) * 3))
+
+static unsigned int table_size_for (unsigned int n)
 {
-	hentry* entry = xMalloc (1, hentry);
+	unsigned int size = HTABLE_MIN_SIZE;
+
+	while (size < n)
+		size <<= 1;
+	return size;
+}
+
+static unsigned int slot_distance (const hashTable *htable, unsigned int index, unsigned int hash)
+{
+	return (index - hash) & (htable->size - 1);
+}
+
+static hchunk *chunk_new (unsigned int size, hchunk *next)
+{
+	hchunk *chunk = eMalloc (sizeof (hchunk) + sizeof (hentry) * size);
+
+	chunk->next = next;
+	chunk->size = size;
+	chunk->used = 0;
+	return chunk;
+}
+
+static void chunk_reclaim (hchunk *chunk)
+{
+	while (chunk)
+	{
+		hchunk *next = chunk->next;
+		eFree (chunk);
+		chunk = next;
+	}
+}
+
+static hentry* entry_new (hashTable *htable, void *key, void *value, hentry* next)
+{
+	hentry* entry;
+
+	if (htable->freeEntries)
+	{
+		entry = htable->freeEntries;
+		htable->freeEntries = entry->next;
+	}
+	else
+	{
+		hchunk *chunk = htable->chunks;
+		if (chunk == NULL || chunk->used == chunk->size)
+		{
+			unsigned int size = chunk? chunk->size * 2: HTABLE_CHUNK_MIN;
+			if (size > HTABLE_CHUNK_MAX)
+				size = HTABLE_CHUNK_MAX;
+			chunk = chunk_new (size, chunk);
+			htable->chunks = chunk;
+		}
+		entry = chunk->entries + chunk->used++;
+	}
 
 	entry->key = key;
 	entry->value = value;
 	entry->next = next;
+	htable->nitems++;
 
 	return entry;
 }
@@ -79,77 +167,140 @@ static void entry_reset  (hentry* entry,
 	entry->value = newval;
 }
 
-static hentry* entry_destroy (hentry* entry,
-			      hashTableDeleteFunc keyfreefn,
-			      hashTableDeleteFunc valfreefn)
+static hentry* entry_destroy (hashTable *htable, hentry* entry)
 {
 	hentry* tmp;
 
-	entry_reset (entry, NULL, NULL, keyfreefn, valfreefn);
+	entry_reset (entry, NULL, NULL, htable->keyfreefn, htable->valfreefn);
 	tmp = entry->next;
-	eFree (entry);
+	entry->next = htable->freeEntries;
+	htable->freeEntries = entry;
+	htable->nitems--;
 
 	return tmp;
 }
 
-static void  entry_reclaim (hentry* entry,
-			    hashTableDeleteFunc keyfreefn,
-			    hashTableDeleteFunc valfreefn)
-{
-	while (entry)
-		entry = entry_destroy (entry, keyfreefn, valfreefn);
-}
-
-static void *entry_find (hentry* entry, const void* const key, hashTableEqualFunc equalfn)
+static bool  entry_foreach (hentry *entry, hashTableForeachFunc proc, void *user_data)
 {
 	while (entry)
 	{
-		if (equalfn( key, entry->key))
-			return entry->value;
+		if (!proc (entry->key, entry->value, user_data))
+			return false;
 		entry = entry->next;
 	}
-	return NULL;
+	return true;
 }
 
-static bool		entry_delete (hentry **entry, const void *key, hashTableEqualFunc equalfn,
-			      hashTableDeleteFunc keyfreefn, hashTableDeleteFunc valfreefn)
+/* Put a chain for a key not in the table yet. */
+static void slot_insert (hashTable *htable, unsigned int hash, hentry *chain)
 {
-	while (*entry)
+	unsigned int mask = htable->size - 1;
+	unsigned int i = hash & mask;
+	unsigned int dist = 0;
+
+	while (true)
 	{
-		if (equalfn (key, (*entry)->key))
+		hslot *slot = htable->table + i;
+
+		if (slot->chain == NULL)
 		{
-			*entry = entry_destroy (*entry, keyfreefn, valfreefn);
-			return true;
+			slot->chain = chain;
+			slot->hash = hash;
+			break;
 		}
-		entry = &((*entry)->next);
+
+		unsigned int slot_dist = slot_distance (htable, i, slot->hash);
+		if (slot_dist < dist)
+		{
+			/* Rob the rich: take the slot and carry its owner forward. */
+			hentry *tmp_chain = slot->chain;
+			unsigned int tmp_hash = slot->hash;
+			slot->chain = chain;
+			slot->hash = hash;
+			chain = tmp_chain;
+			hash = tmp_hash;
+			dist = slot_dist;
+		}
+		i = (i + 1) & mask;
+		dist++;
 	}
-	return false;
+	htable->nkeys++;
 }
 
-static bool		entry_update (hentry *entry, void *key, void *value, hashTableEqualFunc equalfn,
-			      hashTableDeleteFunc keyfreefn, hashTableDeleteFunc valfreefn)
+static hslot *slot_find (hashTable *htable, const void *key, unsigned int hash)
 {
-	while (entry)
+	unsigned int mask = htable->size - 1;
+	unsigned int i = hash & mask;
+	unsigned int dist = 0;
+
+	while (true)
 	{
-		if (equalfn (key, entry->key))
-		{
-			entry_reset (entry, key, value, keyfreefn, valfreefn);
-			return true;
-		}
-		entry = entry->next;
+		hslot *slot = htable->table + i;
+
+		if (slot->chain == NULL)
+			return NULL;
+		/* A key cannot be placed after a slot closer to its home. */
+		if (slot_distance (htable, i, slot->hash) < dist)
+			return NULL;
+		if (slot->hash == hash && htable->equalfn (key, slot->chain->key))
+			return slot;
+
+		i = (i + 1) & mask;
+		dist++;
 	}
-	return false;
 }
 
-static bool  entry_foreach (hentry *entry, hashTableForeachFunc proc, void *user_data)
+/* Remove a slot with backward shifting; no tombstone is needed. */
+static void slot_remove (hashTable *htable, hslot *slot)
 {
-	while (entry)
+	unsigned int mask = htable->size - 1;
+	unsigned int i = (unsigned int)(slot - htable->table);
+
+	while (true)
 	{
-		if (!proc (entry->key, entry->value, user_data))
-			return false;
-		entry = entry->next;
+		unsigned int j = (i + 1) & mask;
+		hslot *next = htable->table + j;
+
+		if (next->chain == NULL
+			|| slot_distance (htable, j, next->hash) == 0)
+			break;
+		htable->table[i] = *next;
+		i = j;
 	}
-	return true;
+	htable->table[i].chain = NULL;
+	htable->nkeys--;
+}
+
+static void table_resize (hashTable *htable, unsigned int size)
+{
+	hslot *old_table = htable->table;
+	unsigned int old_size = htable->size;
+	unsigned int i;
+
+	htable->table = xCalloc (size, hslot);
+	htable->size = size;
+	htable->nkeys = 0;
+
+	for (i = 0; i < old_size; i++)
+		if (old_table[i].chain)
+			slot_insert (htable, old_table[i].hash, old_table[i].chain);
+
+	eFree (old_table);
+}
+
+static void table_put (hashTable *htable, void *key, void *value, unsigned int hash, hslot *slot)
+{
+	htable->frozen = false;
+
+	if (slot)
+	{
+		slot->chain = entry_new (htable, key, value, slot->chain);
+		return;
+	}
+
+	if (HTABLE_FULL (htable->nkeys + 1, htable->size))
+		table_resize (htable, htable->size * 2);
+	slot_insert (htable, hash, entry_new (htable, key, value, NULL));
 }
 
 extern hashTable *hashTableNew    (unsigned int size,
@@ -161,8 +312,14 @@ extern hashTable *hashTableNew    (unsigned int size,
 	hashTable *htable;
 
 	htable = xMalloc (1, hashTable);
-	htable->size = size;
-	htable->table = xCalloc (size, hentry*);
+	htable->size = table_size_for (size);
+	htable->table = xCalloc (htable->size, hslot);
+	htable->nkeys = 0;
+	htable->nitems = 0;
+	htable->frozen = false;
+
+	htable->chunks = NULL;
+	htable->freeEntries = NULL;
 
 	htable->hashfn = hashfn;
 	htable->equalfn = equalfn;
@@ -187,6 +344,7 @@ extern void       hashTableDelete (hashTable *htable)
 
 	hashTableClear (htable);
 
+	chunk_reclaim (htable->chunks);
 	eFree (htable->table);
 	eFree (htable);
 }
@@ -197,51 +355,73 @@ extern void       hashTableClear (hashTable *htable)
 	if (!htable)
 		return;
 
-	for (i = 0; i < htable->size; i++)
+	if (htable->keyfreefn || htable->valfreefn)
 	{
-		hentry *entry;
+		for (i = 0; i < htable->size; i++)
+		{
+			hentry *entry;
 
-		entry = htable->table[i];
-		entry_reclaim (entry, htable->keyfreefn, htable->valfreefn);
-		htable->table[i] = NULL;
+			for (entry = htable->table[i].chain; entry; entry = entry->next)
+				entry_reset (entry, NULL, NULL, htable->keyfreefn, htable->valfreefn);
+		}
 	}
+	memset (htable->table, 0, sizeof (hslot) * htable->size);
+	htable->nkeys = 0;
+	htable->nitems = 0;
+	htable->frozen = false;
+
+	/* Keep the newest (and largest) chunk for reuse. */
+	if (htable->chunks)
+	{
+		chunk_reclaim (htable->chunks->next);
+		htable->chunks->next = NULL;
+		htable->chunks->used = 0;
+	}
+	htable->freeEntries = NULL;
 }
 
 extern void       hashTablePutItem    (hashTable *htable, void *key, void *value)
 {
-	unsigned int i;
+	unsigned int hash = htable->hashfn (key);
 
-	i = htable->hashfn (key) % htable->size;
-	htable->table[i] = entry_new(key, value, htable->table[i]);
+	table_put (htable, key, value, hash, slot_find (htable, key, hash));
 }
 
 extern void*      hashTableGetItem   (hashTable *htable, const void * key)
 {
-	unsigned int i;
+	hslot *slot = slot_find (htable, key, htable->hashfn (key));
 
-	i = htable->hashfn (key) % htable->size;
-	return entry_find(htable->table[i], key, htable->equalfn);
+	return slot? slot->chain->value: NULL;
 }
 
 extern bool     hashTableDeleteItem (hashTable *htable, const void *key)
 {
-	unsigned int i;
+	hslot *slot = slot_find (htable, key, htable->hashfn (key));
 
-	i = htable->hashfn (key) % htable->size;
-	return entry_delete(&htable->table[i], key,
-			    htable->equalfn, htable->keyfreefn, htable->valfreefn);
+	if (!slot)
+		return false;
+
+	htable->frozen = false;
+	slot->chain = entry_destroy (htable, slot->chain);
+	if (slot->chain == NULL)
+		slot_remove (htable, slot);
+	return true;
 }
 
 extern bool    hashTableUpdateItem (hashTable *htable, void *key, void *value)
 {
-	unsigned int i;
+	unsigned int hash = htable->hashfn (key);
+	hslot *slot = slot_find (htable, key, hash);
+
+	if (slot)
+	{
+		htable->frozen = false;
+		entry_reset (slot->chain, key, value, htable->keyfreefn, htable->valfreefn);
+		return true;
+	}
 
-	i = htable->hashfn (key) % htable->size;
-	bool r = entry_update(htable->table[i], key, value,
-						  htable->equalfn, htable->keyfreefn, htable->valfreefn);
-	if (!r)
-		htable->table[i] = entry_new(key, value, htable->table[i]);
-	return r;
+	table_put (htable, key, value, hash, NULL);
+	return false;
 }
 
 extern bool    hashTableHasItem    (hashTable *htable, const void *key)
@@ -254,51 +434,59 @@ extern bool       hashTableForeachItem (hashTable *htable, hashTableForeachFunc
 	unsigned int i;
 
 	for (i = 0; i < htable->size; i++)
-		if (!entry_foreach(htable->table[i], proc, user_data))
+		if (!entry_foreach(htable->table[i].chain, proc, user_data))
 			return false;
 	return true;
 }
 
-static bool track_chain (const void *const key, void *value, void *chain_data)
+extern bool       hashTableForeachItemOnChain (hashTable *htable, const void *key, hashTableForeachFunc proc, void *user_data)
 {
-	struct chainTracker *chain_tracker = chain_data;
+	hslot *slot = slot_find (htable, key, htable->hashfn (key));
 
-	if (chain_tracker->equalfn (chain_tracker->target_key, key))
-	{
-		if (! chain_tracker->user_proc (key, value, chain_tracker->user_data))
-			return false;
-	}
-	return true;
+	if (!slot)
+		return true;
+	return entry_foreach (slot->chain, proc, user_data);
 }
 
-extern bool       hashTableForeachItemOnChain (hashTable *htable, const void *key, hashTableForeachFunc proc, void *user_data)
+extern unsigned int hashTableCountItem   (hashTable *htable)
 {
-	unsigned int i;
-	struct chainTracker chain_tracker = {
-		.target_key = key,
-		.user_proc = proc,
-		.user_data = user_data,
-		.equalfn   = htable->equalfn,
-	};
-
-	i = htable->hashfn (key) % htable->size;
-	if (!entry_foreach(htable->table[i], track_chain, &chain_tracker))
-		return false;
-	return true;
+	return htable->nitems;
 }
 
-static bool count (const void *const key CTAGS_ATTR_UNUSED, void *value CTAGS_ATTR_UNUSED, void *data)
+extern void       hashTableFreeze (hashTable *htable)
 {
-	int *c = data;
-	++*c;
-	return true;
-}
+	unsigned int size;
+	unsigned int i;
+	hchunk *chunk;
 
-extern unsigned int hashTableCountItem   (hashTable *htable)
-{
-	int c = 0;
-	hashTableForeachItem (htable, count, &c);
-	return c;
+	if (htable->frozen)
+		return;
+
+	/* Shrink the slot array to the smallest size for the keys. */
+	size = table_size_for (htable->nkeys);
+	while (HTABLE_FULL (htable->nkeys, size))
+		size <<= 1;
+	if (size < htable->size)
+		table_resize (htable, size);
+
+	/* Pack the items into a chunk in the slot order so that a lookup
+	 * touches the memory near the slot array sequentially. */
+	chunk = htable->nitems? chunk_new (htable->nitems, NULL): NULL;
+	for (i = 0; i < htable->size; i++)
+	{
+		hentry **entry;
+
+		for (entry = &htable->table[i].chain; *entry; entry = &(*entry)->next)
+		{
+			hentry *copy = chunk->entries + chunk->used++;
+			*copy = **entry;
+			*entry = copy;
+		}
+	}
+	chunk_reclaim (htable->chunks);
+	htable->chunks = chunk;
+	htable->freeEntries = NULL;
+	htable->frozen = true;
 }
 
 unsigned int hashPtrhash (const void * const x)
@@ -26,6 +26,9 @@
  * key.
  *
  * Use hashTableForeachItemOnChain () to process all items for the same key.
+ *
+ * The size passed to hashTableNew() is just a hint; the htable grows
+ * as items are added.
  */
 typedef struct sHashTable hashTable;
 typedef unsigned int (* hashTableHashFunc)  (const void * const key);
@@ -77,6 +80,12 @@ extern bool       hashTableForeachItemOnChain (hashTable *htable, const void *ke
 
 extern unsigned int hashTableCountItem   (hashTable *htable);
 
+/* Call this when no more item is expected to be added to or deleted
+ * from htable. The storage of htable is compacted for faster lookup.
+ * A frozen htable is still modifiable, but a modification loses the
+ * benefit of freezing until hashTableFreeze() is called again. */
+extern void       hashTableFreeze (hashTable *htable);
+
 extern hashTable* hashTableIntNew (unsigned int size,
 								   hashTableHashFunc hashfn,
 								   hashTableEqualFunc equalfn,
@@ -21,56 +21,81 @@
 #include "parse.h"
 #include "routines.h"
 
+/*
+*   MACROS
+*/
+
+/* A keyword added after building the perfect hash for a language is
+ * looked up linearly until this many keywords are pending. */
+#define KEYWORD_PENDING_MAX 32
+
+/* How many displacement values are tried for a bucket. */
+#define KEYWORD_DISPLACEMENT_MAX (1U << 16)
+
 /*
 *   DATA DECLARATIONS
 */
-typedef struct sHashEntry {
-	struct sHashEntry *next;
-	const char *string;
-	langType language;
+typedef struct sKeywordEntry {
+	const char *string;			/* NULL means an empty slot. */
 	int value;
-} hashEntry;
+	unsigned int hash;
+} keywordEntry;
+
+/* Keywords are managed per language.
+ *
+ * slots[] is a perfect hash built with the "hash and displace" method:
+ * a keyword is put to the bucket selected with its hash value, and
+ * the bucket holds a displacement value that maps each keyword in the
+ * bucket to a distinct slot. A lookup is computing one hash value and
+ * comparing one string.
+ *
+ * Keywords that are added after building slots[], and keywords that
+ * cannot be placed in slots[], are kept in pending[]. pending[] is
+ * scanned linearly. */
+typedef struct sKeywordSet {
+	keywordEntry *slots;
+	unsigned int slotCount;
+	unsigned int *displacements;
+	unsigned int bucketCount;
+
+	keywordEntry *pending;
+	unsigned int pendingCount;
+	unsigned int pendingSize;
+	unsigned int unplaceableCount;	/* in pending[] */
+} keywordSet;
 
 /*
 *   DATA DEFINITIONS
 */
-static const unsigned int TableSize = 2039;  /* prime */
-static hashEntry **HashTable = NULL;
+static keywordSet *KeywordSets = NULL;
+static unsigned int KeywordSetCount = 0;
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-static hashEntry **getHashTable (void)
+static keywordSet *getKeywordSet (langType language, bool create)
 {
-	static bool allocated = false;
+	if (language < 0)
+		return NULL;
 
-	if (! allocated)
+	if ((unsigned int)language >= KeywordSetCount)
 	{
-		unsigned int i;
-
-		HashTable = xMalloc (TableSize, hashEntry*);
+		unsigned int count;
 
-		for (i = 0  ;  i < TableSize  ;  ++i)
-			HashTable [i] = NULL;
+		if (!create)
+			return NULL;
 
-		allocated = true;
+		count = language + 1;
+		KeywordSets = xRealloc (KeywordSets, count, keywordSet);
+		memset (KeywordSets + KeywordSetCount, 0,
+				sizeof (keywordSet) * (count - KeywordSetCount));
+		KeywordSetCount = count;
 	}
-	return HashTable;
+	return KeywordSets + language;
 }
 
-static hashEntry *getHashTableEntry (unsigned long hashedValue)
-{
-	hashEntry **const table = getHashTable ();
-	hashEntry *entry;
-
-	Assert (hashedValue < TableSize);
-	entry = table [hashedValue];
-
-	return entry;
-}
-
-static unsigned int hashValue (const char *const string, langType language)
+static unsigned int hashValue (const char *const string)
 {
 	const signed char *p;
 	unsigned int h = 5381;
@@ -81,80 +106,227 @@ static unsigned int hashValue (const char *const string, langType language)
 	for (p = (const signed char *)string; *p != '\0'; p++)
 		h = (h << 5) + h + tolower (*p);
 
-	/* consider language as an extra "character" and add it to the hash */
-	h = (h << 5) + h + language;
-
 	return h;
 }
 
-static hashEntry *newEntry (
-		const char *const string, langType language, int value)
+/* The finalizer of MurmurHash3 */
+static unsigned int slotIndex (unsigned int hash, unsigned int displacement,
+							   unsigned int slotCount)
 {
-	hashEntry *const entry = xMalloc (1, hashEntry);
+	unsigned int h = hash ^ (displacement * 0x9e3779b9U);
 
-	entry->next     = NULL;
-	entry->string   = string;
-	entry->language = language;
-	entry->value    = value;
+	h ^= h >> 16;
+	h *= 0x85ebca6bU;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35U;
+	h ^= h >> 16;
 
-	return entry;
+	return h % slotCount;
 }
 
-/*  Note that it is assumed that a "value" of zero means an undefined keyword
- *  and clients of this function should observe this. Also, all keywords added
- *  should be added in lower case. If we encounter a case-sensitive language
- *  whose keywords are in upper case, we will need to redesign this.
- */
-extern void addKeyword (const char *const string, langType language, int value)
+static void addPendingEntry (keywordSet *table, const keywordEntry *entry)
 {
-	const unsigned int index = hashValue (string, language) % TableSize;
-	hashEntry *entry = getHashTableEntry (index);
-
-	if (entry == NULL)
+	if (table->pendingCount == table->pendingSize)
 	{
-		hashEntry **const table = getHashTable ();
-		table [index] = newEntry (string, language, value);
+		table->pendingSize = table->pendingSize? table->pendingSize * 2: 8;
+		table->pending = xRealloc (table->pending, table->pendingSize, keywordEntry);
 	}
-	else
+	table->pending [table->pendingCount++] = *entry;
+}
+
+struct bucketOrder {
+	unsigned int size;
+	unsigned int index;
+};
+
+static int compareBucketOrder (const void *a, const void *b)
+{
+	const struct bucketOrder *oa = a;
+	const struct bucketOrder *ob = b;
+
+	if (oa->size != ob->size)
+		return (oa->size < ob->size)? 1: -1;
+	return (oa->index < ob->index)? -1: 1;
+}
+
+static bool placeBucket (keywordSet *table, keywordEntry **members,
+						 unsigned int memberCount, unsigned int *placed)
+{
+	unsigned int i, j;
+
+	/* No displacement can separate keywords having the same hash value. */
+	for (i = 0; i < memberCount; i++)
+		for (j = 0; j < i; j++)
+			if (members [i]->hash == members [j]->hash)
+				return false;
+
+	for (unsigned int d = 0; d < KEYWORD_DISPLACEMENT_MAX; d++)
 	{
-		hashEntry *prev = NULL;
 
-		while (entry != NULL)
+		for (i = 0; i < memberCount; i++)
 		{
-			if (language == entry->language  &&
-				strcmp (string, entry->string) == 0)
-			{
-				Assert (("Already in table" == NULL));
-			}
-			prev = entry;
-			entry = entry->next;
+			placed [i] = slotIndex (members [i]->hash, d, table->slotCount);
+			if (table->slots [placed [i]].string)
+				break;
+			for (j = 0; j < i; j++)
+				if (placed [j] == placed [i])
+					break;
+			if (j < i)
+				break;
 		}
-		if (entry == NULL)
+		if (i < memberCount)
+			continue;
+
+		for (i = 0; i < memberCount; i++)
+			table->slots [placed [i]] = *members [i];
+		table->displacements [members [0]->hash % table->bucketCount] = d;
+		return true;
+	}
+	return false;
+}
+
+static void buildPerfectHash (keywordSet *table)
+{
+	keywordEntry *entries;
+	unsigned int count = 0;
+	unsigned int i;
+
+	entries = xMalloc (table->slotCount + table->pendingCount, keywordEntry);
+	for (i = 0; i < table->slotCount; i++)
+		if (table->slots [i].string)
+			entries [count++] = table->slots [i];
+	memcpy (entries + count, table->pending, sizeof (keywordEntry) * table->pendingCount);
+	count += table->pendingCount;
+
+	if (table->slots)
+		eFree (table->slots);
+	if (table->displacements)
+		eFree (table->displacements);
+	table->pendingCount = 0;
+	table->unplaceableCount = 0;
+
+	table->slotCount = count;
+	table->slots = xCalloc (count, keywordEntry);
+	table->bucketCount = count / 4 + 1;
+	table->displacements = xCalloc (table->bucketCount, unsigned int);
+
+	/* Distribute the keywords to the buckets; the members of a bucket
+	 * are linked via bucketNext. */
+	unsigned int *bucketHead = xMalloc (table->bucketCount, unsigned int);
+	unsigned int *bucketNext = xMalloc (count, unsigned int);
+	struct bucketOrder *order = xMalloc (table->bucketCount, struct bucketOrder);
+	keywordEntry **members = xMalloc (count, keywordEntry *);
+	unsigned int *placed = xMalloc (count, unsigned int);
+
+	for (i = 0; i < table->bucketCount; i++)
+	{
+		bucketHead [i] = count;
+		order [i].size = 0;
+		order [i].index = i;
+	}
+	/* Keep the order of addition in a bucket: when keywords cannot be
+	 * placed, the earlier added one must be found first in pending[]. */
+	for (i = count; i-- > 0; )
+	{
+		unsigned int b = entries [i].hash % table->bucketCount;
+		bucketNext [i] = bucketHead [b];
+		bucketHead [b] = i;
+		order [b].size++;
+	}
+
+	/* Place larger buckets first while the slots are still sparse. */
+	qsort (order, table->bucketCount, sizeof (struct bucketOrder),
+		   compareBucketOrder);
+
+	for (i = 0; i < table->bucketCount && order [i].size > 0; i++)
+	{
+		unsigned int memberCount = 0;
+
+		for (unsigned int e = bucketHead [order [i].index]; e != count; e = bucketNext [e])
+			members [memberCount++] = entries + e;
+
+		if (!placeBucket (table, members, memberCount, placed))
 		{
-			Assert (prev != NULL);
-			prev->next = newEntry (string, language, value);
+			/* e.g. two keywords having the same hash value */
+			for (unsigned int m = 0; m < memberCount; m++)
+				addPendingEntry (table, members [m]);
+			table->unplaceableCount += memberCount;
 		}
 	}
+
+	eFree (placed);
+	eFree (members);
+	eFree (order);
+	eFree (bucketNext);
+	eFree (bucketHead);
+	eFree (entries);
+}
+
+/*  Note that it is assumed that a "value" of zero means an undefined keyword
+ *  and clients of this function should observe this. Also, all keywords added
+ *  should be added in lower case. If we encounter a case-sensitive language
+ *  whose keywords are in upper case, we will need to redesign this.
+ */
+extern void addKeyword (const char *const string, langType language, int value)
+{
+	keywordSet *table = getKeywordSet (language, true);
+	keywordEntry entry = {
+		.string = string,
+		.value = value,
+		.hash = hashValue (string),
+	};
+
+	Assert (table);
+	Assert (lookupKeyword (string, language) == KEYWORD_NONE);
+	addPendingEntry (table, &entry);
+}
+
+extern void indexKeywordTable (langType language)
+{
+	keywordSet *table = getKeywordSet (language, false);
+
+	if (table && table->pendingCount > table->unplaceableCount)
+		buildPerfectHash (table);
+}
+
+static bool matchEntry (const keywordEntry *entry, const char *const string,
+						unsigned int hash, bool caseSensitive)
+{
+	return (entry->string
+			&& entry->hash == hash
+			&& ((caseSensitive && strcmp (string, entry->string) == 0) ||
+				(!caseSensitive && strcasecmp (string, entry->string) == 0)));
 }
 
 static int lookupKeywordFull (const char *const string, bool caseSensitive, langType language)
 {
-	const unsigned int index = hashValue (string, language) % TableSize;
-	hashEntry *entry = getHashTableEntry (index);
-	int result = KEYWORD_NONE;
+	keywordSet *table = getKeywordSet (language, false);
+	unsigned int hash;
+	unsigned int i;
+
+	if (table == NULL)
+		return KEYWORD_NONE;
+
+	if (table->pendingCount - table->unplaceableCount > KEYWORD_PENDING_MAX)
+		buildPerfectHash (table);
 
-	while (entry != NULL)
+	hash = hashValue (string);
+	if (table->slotCount > 0)
 	{
-		if (language == entry->language &&
-			((caseSensitive && strcmp (string, entry->string) == 0) ||
-			 (!caseSensitive && strcasecmp (string, entry->string) == 0)))
-		{
-			result = entry->value;
-			break;
-		}
-		entry = entry->next;
+		unsigned int d = table->displacements [hash % table->bucketCount];
+		const keywordEntry *entry = table->slots + slotIndex (hash, d, table->slotCount);
+
+		if (matchEntry (entry, string, hash, caseSensitive))
+			return entry->value;
+	}
+
+	for (i = 0; i < table->pendingCount; i++)
+	{
+		if (matchEntry (table->pending + i, string, hash, caseSensitive))
+			return table->pending [i].value;
 	}
-	return result;
+
+	return KEYWORD_NONE;
 }
 
 extern int lookupKeyword (const char *const string, langType language)
@@ -169,75 +341,57 @@ extern int lookupCaseKeyword (const char *const string, langType language)
 
 extern void freeKeywordTable (void)
 {
-	if (HashTable != NULL)
-	{
-		unsigned int i;
+	unsigned int i;
 
-		for (i = 0  ;  i < TableSize  ;  ++i)
-		{
-			hashEntry *entry = HashTable [i];
-
-			while (entry != NULL)
-			{
-				hashEntry *next = entry->next;
-				eFree (entry);
-				entry = next;
-			}
-		}
-		eFree (HashTable);
+	for (i = 0; i < KeywordSetCount; i++)
+	{
+		keywordSet *table = KeywordSets + i;
+
+		if (table->slots)
+			eFree (table->slots);
+		if (table->displacements)
+			eFree (table->displacements);
+		if (table->pending)
+			eFree (table->pending);
 	}
+	if (KeywordSets)
+		eFree (KeywordSets);
+	KeywordSets = NULL;
+	KeywordSetCount = 0;
 }
 
-#ifdef DEBUG
-
-static void printEntry (const hashEntry *const entry)
+static void printEntries (FILE *fp, const keywordEntry *entries, unsigned int count,
+						  langType language)
 {
-	printf ("  %-15s %-7s\n", entry->string, getLanguageName (entry->language));
-}
+	unsigned int i;
 
-static unsigned int printBucket (const unsigned int i)
-{
-	hashEntry **const table = getHashTable ();
-	hashEntry *entry = table [i];
-	unsigned int measure = 1;
-	bool first = true;
-
-	printf ("%2d:", i);
-	if (entry == NULL)
-		printf ("\n");
-	else while (entry != NULL)
+	for (i = 0; i < count; i++)
 	{
-		if (! first)
-			printf ("    ");
-		else
-		{
-			printf (" ");
-			first = false;
-		}
-		printEntry (entry);
-		entry = entry->next;
-		measure = 2 * measure;
+		if (entries [i].string)
+			fprintf (fp, "%s	%s\n", entries [i].string, getLanguageName (language));
 	}
-	return measure - 1;
 }
 
+#ifdef DEBUG
+
 extern void printKeywordTable (void)
 {
-	unsigned long emptyBucketCount = 0;
-	unsigned long measure = 0;
 	unsigned int i;
 
-	for (i = 0  ;  i < TableSize  ;  ++i)
+	for (i = 0; i < KeywordSetCount; i++)
 	{
-		const unsigned int pass = printBucket (i);
+		const keywordSet *table = KeywordSets + i;
 
-		measure += pass;
-		if (pass == 0)
-			++emptyBucketCount;
-	}
+		if (table->slotCount == 0 && table->pendingCount == 0)
+			continue;
 
-	printf ("spread measure = %ld\n", measure);
-	printf ("%ld empty buckets\n", emptyBucketCount);
+		printf ("%s: %u slots, %u buckets, %u pending (%u unplaceable)\n",
+				getLanguageName (i),
+				table->slotCount, table->bucketCount,
+				table->pendingCount, table->unplaceableCount);
+		printEntries (stdout, table->slots, table->slotCount, i);
+		printEntries (stdout, table->pending, table->pendingCount, i);
+	}
 }
 
 #endif
@@ -245,15 +399,13 @@ extern void printKeywordTable (void)
 extern void dumpKeywordTable (FILE *fp)
 {
 	unsigned int i;
-	for (i = 0  ;  i < TableSize  ;  ++i)
+
+	for (i = 0; i < KeywordSetCount; i++)
 	{
-		hashEntry **const table = getHashTable ();
-		hashEntry *entry = table [i];
-		while (entry != NULL)
-		{
-			fprintf(fp, "%s	%s\n", entry->string, getLanguageName (entry->language));
-			entry = entry->next;
-		}
+		const keywordSet *table = KeywordSets + i;
+
+		printEntries (fp, table->slots, table->slotCount, i);
+		printEntries (fp, table->pending, table->pendingCount, i);
 	}
 }
 
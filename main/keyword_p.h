@@ -14,9 +14,13 @@
 */
 #include "general.h"  /* must always come first */
 #include <stdio.h>
+#include "types.h"
 
 extern void freeKeywordTable (void);
 
+/* Build the perfect hash for the keywords added to the language so far. */
+extern void indexKeywordTable (langType language);
+
 extern void dumpKeywordTable (FILE *fp);
 
 #ifdef DEBUG
@@ -35,6 +35,7 @@
 #include "htable.h"
 #include "kind.h"
 #include "options.h"
+#include "options_p.h"
 #include "parse_p.h"
 #include "promise.h"
 #include "read.h"
@@ -137,7 +138,13 @@ struct mTableActionSpec {
 };
 
 typedef struct {
+	/* A pattern is compiled when it is used first time.
+	 * Both pattern and regex.source are NULL if compiling failed. */
 	regex_t *pattern;
+	struct {
+		char *source;
+		int cflags;
+	} regex;
 	enum pType type;
 	bool exclusive;
 	bool accept_empty_name;
@@ -261,9 +268,17 @@ static void deletePattern (regexPattern *p)
 	if (p->refcount > 0)
 		return;
 
-	regfree (p->pattern);
-	eFree (p->pattern);
-	p->pattern = NULL;
+	if (p->pattern)
+	{
+		regfree (p->pattern);
+		eFree (p->pattern);
+		p->pattern = NULL;
+	}
+	if (p->regex.source)
+	{
+		eFree (p->regex.source);
+		p->regex.source = NULL;
+	}
 
 	if (p->type == PTRN_TAG)
 	{
@@ -552,12 +567,14 @@ static regexPattern * refPattern (regexPattern * ptrn)
 	return ptrn;
 }
 
-static regexPattern * newPattern (regex_t* const pattern,
+static regexPattern * newPattern (const char* const regex, int cflags,
 								  enum regexParserType regptype)
 {
 	regexPattern *ptrn = xCalloc(1, regexPattern);
 
-	ptrn->pattern = pattern;
+	ptrn->pattern = NULL;
+	ptrn->regex.source = eStrdup (regex);
+	ptrn->regex.cflags = cflags;
 	ptrn->exclusive = false;
 	ptrn->accept_empty_name = false;
 	ptrn->regptype = regptype;
@@ -584,20 +601,20 @@ static regexTableEntry * newRefPatternEntry (regexTableEntry * other)
 	return entry;
 }
 
-static regexTableEntry * newEntry (regex_t* const pattern,
+static regexTableEntry * newEntry (const char* const regex, int cflags,
 								   enum regexParserType regptype)
 {
 	regexTableEntry *entry = xCalloc (1, regexTableEntry);
-	entry->pattern = newPattern (pattern, regptype);
+	entry->pattern = newPattern (regex, cflags, regptype);
 	return entry;
 }
 
-static regexPattern* addCompiledTagCommon (struct lregexControlBlock *lcb,
-										   int table_index,
-										   regex_t* const pattern,
-										   enum regexParserType regptype)
+static regexPattern* addTagCommon (struct lregexControlBlock *lcb,
+								   int table_index,
+								   const char* const regex, int cflags,
+								   enum regexParserType regptype)
 {
-	regexTableEntry *entry = newEntry (pattern, regptype);
+	regexTableEntry *entry = newEntry (regex, cflags, regptype);
 
 	if (regptype == REG_PARSER_MULTI_TABLE)
 	{
@@ -1222,15 +1239,16 @@ static void patternEvalFlags (struct lregexControlBlock *lcb,
 		flagsEval (flags, multitablePtrnFlagDef, ARRAY_SIZE(multitablePtrnFlagDef), &commonFlagData);
 }
 
-static regexPattern *addCompiledTagPattern (struct lregexControlBlock *lcb,
-											int table_index,
-											enum regexParserType regptype, regex_t* const pattern,
+static regexPattern *addTagPattern (struct lregexControlBlock *lcb,
+									int table_index,
+									enum regexParserType regptype,
+									const char* const regex, int cflags,
 					    const char* const name, char kindLetter, const char* kindName,
 					    char *const description, const char* flags,
 					    bool kind_explicitly_defined,
 					    bool *disabled)
 {
-	regexPattern * ptrn = addCompiledTagCommon(lcb, table_index, pattern, regptype);
+	regexPattern * ptrn = addTagCommon(lcb, table_index, regex, cflags, regptype);
 
 	ptrn->type = PTRN_TAG;
 	ptrn->u.tag.name_pattern = eStrdup (name);
@@ -1242,7 +1260,8 @@ static regexPattern *addCompiledTagPattern (struct lregexControlBlock *lcb,
 	return ptrn;
 }
 
-static regexPattern *addCompiledCallbackPattern (struct lregexControlBlock *lcb, regex_t* const pattern,
+static regexPattern *addCallbackPattern (struct lregexControlBlock *lcb,
+					const char* const regex, int cflags,
 					const regexCallback callback, const char* flags,
 					bool *disabled,
 					void *userData)
@@ -1250,7 +1269,7 @@ static regexPattern *addCompiledCallbackPattern (struct lregexControlBlock *lcb,
 	regexPattern * ptrn;
 	bool exclusive = false;
 	flagsEval (flags, prePtrnFlagDef, ARRAY_SIZE(prePtrnFlagDef), &exclusive);
-	ptrn = addCompiledTagCommon(lcb, TABLE_INDEX_UNUSED, pattern, REG_PARSER_SINGLE_LINE);
+	ptrn = addTagCommon(lcb, TABLE_INDEX_UNUSED, regex, cflags, REG_PARSER_SINGLE_LINE);
 	ptrn->type    = PTRN_CALLBACK;
 	ptrn->u.callback.function = callback;
 	ptrn->u.callback.userData = userData;
@@ -1303,21 +1322,24 @@ static flagDefinition regexFlagDefs[] = {
 	  NULL, "applied in a case-insensitive manner"},
 };
 
-static regex_t* compileRegex (enum regexParserType regptype,
-							  const char* const regexp, const char* const flags)
+static int evalRegexFlags (enum regexParserType regptype, const char* const flags)
 {
 	int cflags = REG_EXTENDED | REG_NEWLINE;
 
 	if (regptype == REG_PARSER_MULTI_TABLE)
 		cflags &= ~REG_NEWLINE;
 
-	regex_t *result;
-	int errcode;
-
 	flagsEval (flags,
 		   regexFlagDefs,
 		   ARRAY_SIZE(regexFlagDefs),
 		   &cflags);
+	return cflags;
+}
+
+static regex_t* compileRegex (const char* const regexp, int cflags)
+{
+	regex_t *result;
+	int errcode;
 
 	result = xMalloc (1, regex_t);
 	errcode = regcomp (result, regexp, cflags);
@@ -1333,6 +1355,22 @@ static regex_t* compileRegex (enum regexParserType regptype,
 	return result;
 }
 
+/* Most of patterns defined in optlib parsers and preloaded option files
+ * are never used in a run tagging a few files. Compiling a pattern is
+ * delayed till a parser tries to match it against input. The patterns
+ * given on the command line are compiled when the options are processed
+ * to report broken ones early. */
+static regex_t* getRegex (regexPattern *ptrn)
+{
+	if (ptrn->pattern == NULL && ptrn->regex.source)
+	{
+		ptrn->pattern = compileRegex (ptrn->regex.source, ptrn->regex.cflags);
+		eFree (ptrn->regex.source);
+		ptrn->regex.source = NULL;
+	}
+	return ptrn->pattern;
+}
+
 
 /* If a letter and/or a name are defined in kindSpec, return true. */
 static bool parseKinds (
@@ -1694,6 +1732,9 @@ static bool matchRegexPattern (struct lregexControlBlock *lcb,
 	if (patbuf->disabled && *(patbuf->disabled))
 		return false;
 
+	if (getRegex (patbuf) == NULL)
+		return false;
+
 	match = regexec (patbuf->pattern, vStringValue (line),
 			 BACK_REFERENCE_COUNT, pmatch, 0);
 	if (match == 0)
@@ -1735,8 +1776,23 @@ static bool matchRegexPattern (struct lregexControlBlock *lcb,
 	return result;
 }
 
+/* Match PREG against the input from CURRENT to END. The input
+ * doesn't have to be terminated with NUL. Without REG_STARTEND,
+ * the caller must make the input terminated. */
+static int regexecWithEnd (regex_t *preg, const char *current, const char *end,
+						   size_t nmatch, regmatch_t pmatch[])
+{
+#ifdef REG_STARTEND
+	pmatch [0].rm_so = 0;
+	pmatch [0].rm_eo = end - current;
+	return regexec (preg, current, nmatch, pmatch, REG_STARTEND);
+#else
+	return regexec (preg, current, nmatch, pmatch, 0);
+#endif
+}
+
 static bool matchMultilineRegexPattern (struct lregexControlBlock *lcb,
-										const vString* const allLines,
+										const char *allLines, size_t length,
 										regexTableEntry *entry)
 {
 	const char *start;
@@ -1756,11 +1812,14 @@ static bool matchMultilineRegexPattern (struct lregexControlBlock *lcb,
 	if (patbuf->disabled && *(patbuf->disabled))
 		return false;
 
-	current = start = vStringValue (allLines);
+	if (getRegex (patbuf) == NULL)
+		return false;
+
+	current = start = allLines;
 	do
 	{
-		match = regexec (patbuf->pattern, current,
-						 BACK_REFERENCE_COUNT, pmatch, 0);
+		match = regexecWithEnd (patbuf->pattern, current, start + length,
+								BACK_REFERENCE_COUNT, pmatch);
 		if (match != 0)
 		{
 			entry->statistics.unmatch++;
@@ -1811,7 +1870,7 @@ static bool matchMultilineRegexPattern (struct lregexControlBlock *lcb,
 		}
 		current += delta;
 
-	} while (current < start + vStringLength (allLines));
+	} while (current < start + length);
 
 	return result;
 }
@@ -1944,9 +2003,7 @@ static regexPattern *addTagRegexInternal (struct lregexControlBlock *lcb,
 	if (!regexAvailable)
 		return NULL;
 
-	regex_t* const cp = compileRegex (regptype, regex, flags);
-	if (cp == NULL)
-		return NULL;
+	const int cflags = evalRegexFlags (regptype, flags);
 
 	char kindLetter;
 	char* kindName;
@@ -2010,11 +2067,11 @@ static regexPattern *addTagRegexInternal (struct lregexControlBlock *lcb,
 		}
 	}
 
-	regexPattern *rptr = addCompiledTagPattern (lcb, table_index,
-												regptype, cp, name,
-												kindLetter, kindName, description, flags,
-												explictly_defined,
-												disabled);
+	regexPattern *rptr = addTagPattern (lcb, table_index,
+										regptype, regex, cflags, name,
+										kindLetter, kindName, description, flags,
+										explictly_defined,
+										disabled);
 	rptr->pattern_string = escapeRegexPattern(regex);
 
 	eFree (kindName);
@@ -2083,13 +2140,10 @@ extern void addCallbackRegex (struct lregexControlBlock *lcb,
 		return;
 
 
-	regex_t* const cp = compileRegex (REG_PARSER_SINGLE_LINE, regex, flags);
-	if (cp != NULL)
-	{
-		regexPattern *rptr = addCompiledCallbackPattern (lcb, cp, callback, flags,
-														 disabled, userData);
-		rptr->pattern_string = escapeRegexPattern(regex);
-	}
+	const int cflags = evalRegexFlags (REG_PARSER_SINGLE_LINE, flags);
+	regexPattern *rptr = addCallbackPattern (lcb, regex, cflags, callback, flags,
+											 disabled, userData);
+	rptr->pattern_string = escapeRegexPattern(regex);
 }
 
 static void addTagRegexOption (struct lregexControlBlock *lcb,
@@ -2140,8 +2194,32 @@ static void addTagRegexOption (struct lregexControlBlock *lcb,
 		regex_pat = eStrdup (pattern);
 
 	if (parseTagRegex (regptype, regex_pat, &name, &kinds, &flags))
-		addTagRegexInternal (lcb, table_index, regptype, regex_pat, name, kinds, flags,
-							 NULL);
+	{
+		regex_t *compiled = NULL;
+
+		/* A broken pattern given on the command line is reported before
+		 * anything of it, like its kind, is registered. */
+		if (isProcessingCommandLineOptions ())
+			compiled = compileRegex (regex_pat, evalRegexFlags (regptype, flags));
+
+		if (compiled || !isProcessingCommandLineOptions ())
+		{
+			regexPattern *ptrn = addTagRegexInternal (lcb, table_index, regptype,
+													  regex_pat, name, kinds, flags,
+													  NULL);
+			if (ptrn && compiled)
+			{
+				ptrn->pattern = compiled;
+				eFree (ptrn->regex.source);
+				ptrn->regex.source = NULL;
+			}
+			else if (compiled)
+			{
+				regfree (compiled);
+				eFree (compiled);
+			}
+		}
+	}
 
 	eFree (regex_pat);
 }
@@ -2245,11 +2323,23 @@ extern bool regexNeedsMultilineBuffer (struct lregexControlBlock *lcb)
 		return false;
 }
 
-extern bool matchMultilineRegex (struct lregexControlBlock *lcb, const vString* const allLines)
+#ifndef REG_STARTEND
+# define withTerminatedInput(INPUT,LENGTH,COPY) do {		\
+		COPY = vStringNew ();								\
+		vStringNCatS (COPY, INPUT, LENGTH);					\
+		INPUT = vStringValue (COPY);						\
+	} while (0)
+#endif
+
+extern bool matchMultilineRegex (struct lregexControlBlock *lcb, const char *allLines, size_t length)
 {
 	bool result = false;
 
 	unsigned int i;
+#ifndef REG_STARTEND
+	vString *copy;
+	withTerminatedInput (allLines, length, copy);
+#endif
 
 	for (i = 0; i < ptrArrayCount(lcb->entries [REG_PARSER_MULTI_LINE]); ++i)
 	{
@@ -2260,8 +2350,11 @@ extern bool matchMultilineRegex (struct lregexControlBlock *lcb, const vString*
 			&& (!isXtagEnabled (entry->pattern->xtagType)))
 			continue;
 
-		result = matchMultilineRegexPattern (lcb, allLines, entry) || result;
+		result = matchMultilineRegexPattern (lcb, allLines, length, entry) || result;
 	}
+#ifndef REG_STARTEND
+	vStringDelete (copy);
+#endif
 	return result;
 }
 
@@ -2332,14 +2425,14 @@ static void dumpTstack(FILE* fp, ptrArray *tstack)
 	fprintf(fp, "\n");
 }
 
-static void printInputLine(FILE* vfp, const char *c, const off_t offset)
+static void printInputLine(FILE* vfp, const char *c, const char *end, const off_t offset)
 {
 	vString *v = vStringNew ();
 
-	for (; *c && (*c != '\n'); c++)
+	for (; c < end && *c && (*c != '\n'); c++)
 		vStringPut(v, *c);
 
-	if (vStringLength (v) == 0 && *c == '\n')
+	if (vStringLength (v) == 0 && c < end && *c == '\n')
 		vStringCatS (v, "\\n");
 
 	fprintf (vfp, "\ninput : \"%s\" L%lu\n",
@@ -2377,29 +2470,30 @@ static void printMultitableMessage(const langType language,
 }
 
 static struct regexTable * matchMultitableRegexTable (struct lregexControlBlock *lcb,
-													  struct regexTable *table, const vString *const start, unsigned int *offset)
+													  struct regexTable *table, const char *cstart, size_t length,
+													  unsigned int *offset)
 {
 	struct regexTable *next = NULL;
 	const char *current;
+	const char *const end = cstart + length;
 	regmatch_t pmatch [BACK_REFERENCE_COUNT];
-	const char *cstart = vStringValue(start);
 	unsigned int delta;
 
 
  restart:
 	current = cstart + *offset;
 
-	/* Accept the case *offset == vStringLength(start)
+	/* Accept the case *offset == length
 	   because we want an empty regex // still matches empty input. */
-	if (*offset > vStringLength(start))
+	if (*offset > length)
 	{
-		*offset = vStringLength(start);
+		*offset = length;
 		goto out;
 	}
 
 	BEGIN_VERBOSE(vfp);
 	{
-		printInputLine(vfp, current, *offset);
+		printInputLine(vfp, current, end, *offset);
 	}
 	END_VERBOSE();
 
@@ -2414,7 +2508,9 @@ static struct regexTable * matchMultitableRegexTable (struct lregexControlBlock
 		BEGIN_VERBOSE(vfp);
 		{
 			char s[3];
-			if (*current == '\n')
+			if (current == end)
+				s [0] = '\0';
+			else if (*current == '\n')
 			{
 				s [0] = '\\';
 				s [1] = 'n';
@@ -2453,8 +2549,11 @@ static struct regexTable * matchMultitableRegexTable (struct lregexControlBlock
 		if (ptrn->disabled && *(ptrn->disabled))
 			continue;
 
-		match = regexec (ptrn->pattern, current,
-						 BACK_REFERENCE_COUNT, pmatch, 0);
+		if (getRegex (ptrn) == NULL)
+			continue;
+
+		match = regexecWithEnd (ptrn->pattern, current, end,
+								BACK_REFERENCE_COUNT, pmatch);
 
 		if (match == 0)
 		{
@@ -2657,7 +2756,7 @@ extern void printMultitableStatistics (struct lregexControlBlock *lcb)
 	}
 }
 
-extern bool matchMultitableRegex (struct lregexControlBlock *lcb, const vString* const allLines)
+extern bool matchMultitableRegex (struct lregexControlBlock *lcb, const char *allLines, size_t length)
 {
 	if (ptrArrayCount (lcb->tables) == 0)
 		return false;
@@ -2668,11 +2767,15 @@ extern bool matchMultitableRegex (struct lregexControlBlock *lcb, const vString*
 	int motionless_counter = 0;
 	unsigned int last_offset;
 
+#ifndef REG_STARTEND
+	vString *copy;
+	withTerminatedInput (allLines, length, copy);
+#endif
 
 	while (table)
 	{
 		last_offset = offset;
-		table = matchMultitableRegexTable(lcb, table, allLines, &offset);
+		table = matchMultitableRegexTable(lcb, table, allLines, length, &offset);
 
 		if (last_offset == offset)
 			motionless_counter++;
@@ -2707,6 +2810,9 @@ extern bool matchMultitableRegex (struct lregexControlBlock *lcb, const vString*
 		}
 	}
 
+#ifndef REG_STARTEND
+	vStringDelete (copy);
+#endif
 	return true;
 }
 
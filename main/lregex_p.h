@@ -63,8 +63,9 @@ extern void addCallbackRegex (struct lregexControlBlock *lcb,
 							  bool *disabled,
 							  void * userData);
 extern bool regexNeedsMultilineBuffer (struct lregexControlBlock *lcb);
-extern bool matchMultilineRegex (struct lregexControlBlock *lcb, const vString* const allLines);
-extern bool matchMultitableRegex (struct lregexControlBlock *lcb, const vString* const allLines);
+/* ALLLINES doesn't have to be terminated with NUL. */
+extern bool matchMultilineRegex (struct lregexControlBlock *lcb, const char *allLines, size_t length);
+extern bool matchMultitableRegex (struct lregexControlBlock *lcb, const char *allLines, size_t length);
 
 extern void notifyRegexInputStart (struct lregexControlBlock *lcb);
 extern void notifyRegexInputEnd (struct lregexControlBlock *lcb);
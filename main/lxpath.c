@@ -9,8 +9,14 @@
 */
 
 #include "general.h"  /* must always come first */
+
+#include <ctype.h>
+#include <string.h>
+
+#include "budget_p.h"
 #include "debug.h"
 #include "entry.h"
+#include "field.h"
 #include "options.h"
 #include "parse_p.h"
 #include "read.h"
@@ -19,8 +25,380 @@
 #include "xtag.h"
 
 #ifdef HAVE_LIBXML
+#include <libxml/parser.h>
 #include <libxml/xpath.h>
 #include <libxml/tree.h>
+#include <libxml/xmlreader.h>
+
+/*
+ * Simple xpath expressions
+ *
+ * Most of the expressions in the tables are location paths made of
+ * child and descendant steps. Such an expression is compiled to a
+ * pattern. The patterns in a table are matched against the nodes while
+ * walking the tree once, instead of evaluating each expression with
+ * libxml2 from the context node. A pattern is made of the steps:
+ *
+ *   NAME, *, *[local-name()='NAME'], @NAME, and text()
+ *
+ * separated by "/" or "//". It may start with "/", "//", or "./".
+ * The other expressions are evaluated with libxml2.
+ *
+ * If all the expressions in the tables of a parser are compiled to
+ * patterns, and the parser doesn't use the tree after the walk, the
+ * input is read with xmlTextReader instead of building the whole tree.
+ * The children of the root element are expanded one by one, and each
+ * of them is freed after its nodes are matched. The tags are made in
+ * the order of the table within each child of the root element. The
+ * tags made before an error in a malformed input are kept, while no
+ * tag is made if the whole tree cannot be built.
+ */
+enum xpathAxis {
+	XPATH_AXIS_CHILD,
+	XPATH_AXIS_DESCENDANT,
+};
+
+enum xpathTest {
+	XPATH_TEST_ELEMENT,
+	XPATH_TEST_ANY_ELEMENT,
+	XPATH_TEST_LOCAL_NAME,
+	XPATH_TEST_ATTRIBUTE,
+	XPATH_TEST_TEXT,
+};
+
+struct sXpathStep {
+	enum xpathAxis axis;
+	enum xpathTest test;
+	char *name;
+};
+
+struct sXpathPattern {
+	bool absolute;
+	bool descendant;			/* has a descendant step */
+	bool text;					/* ends with text() */
+	unsigned int count;
+	struct sXpathStep *steps;
+};
+
+struct xpathMatch {
+	unsigned int index;			/* in the table */
+	xmlNode *node;
+};
+
+struct xpathWalk {
+	const tagXpathTableTable *xpathTableTable;
+	xmlNode *context;
+	xmlNode *document;			/* NULL if absolute patterns are not used */
+	unsigned int maxDepth;		/* 0 means unlimited */
+	bool text;
+
+	struct xpathMatch *matches;
+	size_t count;
+	size_t size;
+};
+
+static size_t xpathNameLength (const char *p)
+{
+	size_t n = 0;
+
+	if (!(isalpha ((unsigned char)p [0]) || p [0] == '_'))
+		return 0;
+
+	while (isalnum ((unsigned char)p [n]) || p [n] == '_'
+		   || p [n] == '-' || p [n] == '.')
+		n++;
+	return n;
+}
+
+static bool parseXpathStep (const char **pp, struct sXpathStep *step)
+{
+	static const char localName [] = "*[local-name()='";
+	const char *p = *pp;
+	size_t n;
+
+	step->name = NULL;
+	if (*p == '@')
+	{
+		n = xpathNameLength (p + 1);
+		if (n == 0)
+			return false;
+		step->test = XPATH_TEST_ATTRIBUTE;
+		step->name = eStrndup (p + 1, n);
+		p += 1 + n;
+	}
+	else if (strncmp (p, "text()", 6) == 0)
+	{
+		step->test = XPATH_TEST_TEXT;
+		p += 6;
+	}
+	else if (strncmp (p, localName, strlen (localName)) == 0)
+	{
+		p += strlen (localName);
+		n = xpathNameLength (p);
+		if (n == 0 || strncmp (p + n, "']", 2) != 0)
+			return false;
+		step->test = XPATH_TEST_LOCAL_NAME;
+		step->name = eStrndup (p, n);
+		p += n + 2;
+	}
+	else if (*p == '*')
+	{
+		step->test = XPATH_TEST_ANY_ELEMENT;
+		p++;
+	}
+	else
+	{
+		n = xpathNameLength (p);
+		if (n == 0)
+			return false;
+		step->test = XPATH_TEST_ELEMENT;
+		step->name = eStrndup (p, n);
+		p += n;
+	}
+
+	if (*p != '\0' && *p != '/')
+	{
+		if (step->name)
+			eFree (step->name);
+		return false;
+	}
+	*pp = p;
+	return true;
+}
+
+static void freeXpathPattern (struct sXpathPattern *pattern)
+{
+	for (unsigned int i = 0; i < pattern->count; i++)
+	{
+		if (pattern->steps [i].name)
+			eFree (pattern->steps [i].name);
+	}
+	if (pattern->steps)
+		eFree (pattern->steps);
+	eFree (pattern);
+}
+
+static struct sXpathPattern *compileXpathPattern (const char *xpath)
+{
+	struct sXpathPattern *pattern = xMalloc (1, struct sXpathPattern);
+	const char *p = xpath;
+	bool leadingSlash;
+	struct sXpathStep step;
+
+	pattern->absolute = false;
+	pattern->descendant = false;
+	pattern->text = false;
+	pattern->count = 0;
+	pattern->steps = NULL;
+
+	if (p [0] == '.' && p [1] == '/')
+	{
+		p++;
+		leadingSlash = true;
+	}
+	else if (p [0] == '/')
+	{
+		pattern->absolute = true;
+		leadingSlash = true;
+	}
+	else
+		leadingSlash = false;
+
+	while (true)
+	{
+		size_t slashes = strspn (p, "/");
+		if (slashes == 0 && (leadingSlash || pattern->count > 0))
+			goto fail;
+		p += slashes;
+
+		step.axis = (slashes > 1)? XPATH_AXIS_DESCENDANT: XPATH_AXIS_CHILD;
+		if (!parseXpathStep (&p, &step))
+			goto fail;
+
+		pattern->steps = xRealloc (pattern->steps, pattern->count + 1, struct sXpathStep);
+		pattern->steps [pattern->count++] = step;
+
+		if (step.axis == XPATH_AXIS_DESCENDANT)
+			pattern->descendant = true;
+		if (step.test == XPATH_TEST_TEXT)
+			pattern->text = true;
+
+		if (*p == '\0')
+			break;
+		/* Nothing can follow an attribute or a text node. */
+		if (step.test == XPATH_TEST_ATTRIBUTE || step.test == XPATH_TEST_TEXT)
+			goto fail;
+	}
+
+	return pattern;
+
+ fail:
+	freeXpathPattern (pattern);
+	return NULL;
+}
+
+static bool matchXpathStep (xmlNode *node, const struct sXpathStep *step)
+{
+	switch (step->test)
+	{
+	case XPATH_TEST_ELEMENT:
+		/* A name without prefix matches only the elements in no namespace. */
+		return node->type == XML_ELEMENT_NODE && node->ns == NULL
+			&& strcmp ((char *)node->name, step->name) == 0;
+	case XPATH_TEST_ANY_ELEMENT:
+		return node->type == XML_ELEMENT_NODE;
+	case XPATH_TEST_LOCAL_NAME:
+		return node->type == XML_ELEMENT_NODE
+			&& strcmp ((char *)node->name, step->name) == 0;
+	case XPATH_TEST_ATTRIBUTE:
+		return node->type == XML_ATTRIBUTE_NODE
+			&& (node->ns == NULL || node->ns->prefix == NULL)
+			&& strcmp ((char *)node->name, step->name) == 0;
+	case XPATH_TEST_TEXT:
+		return node->type == XML_TEXT_NODE || node->type == XML_CDATA_SECTION_NODE;
+	}
+	return false;
+}
+
+/* Does NODE match the first N steps of PATTERN starting from ANCHOR? */
+static bool matchXpathSteps (xmlNode *node, const struct sXpathPattern *pattern,
+							 unsigned int n, xmlNode *anchor)
+{
+	const struct sXpathStep *step = pattern->steps + n - 1;
+	xmlNode *parent = node->parent;
+
+	if (!matchXpathStep (node, step))
+		return false;
+
+	if (step->axis == XPATH_AXIS_CHILD)
+	{
+		if (n == 1)
+			return parent == anchor;
+		return parent && matchXpathSteps (parent, pattern, n - 1, anchor);
+	}
+
+	for (; parent; parent = parent->parent)
+	{
+		if (n == 1)
+		{
+			if (parent == anchor)
+				return true;
+		}
+		else if (matchXpathSteps (parent, pattern, n - 1, anchor))
+			return true;
+
+		if (parent == anchor)
+			break;
+	}
+	return false;
+}
+
+static bool isXpathPatternUsable (const struct xpathWalk *walk, const tagXpathTable *elt)
+{
+	return elt->xpathCompiled && elt->xpathPattern
+		&& (walk->document || !elt->xpathPattern->absolute);
+}
+
+static void matchXpathPatterns (struct xpathWalk *walk, xmlNode *node)
+{
+	const tagXpathTableTable *xpathTableTable = walk->xpathTableTable;
+
+	for (unsigned int i = 0; i < xpathTableTable->count; i++)
+	{
+		const tagXpathTable *elt = xpathTableTable->table + i;
+		const struct sXpathPattern *pattern = elt->xpathPattern;
+
+		if (!isXpathPatternUsable (walk, elt))
+			continue;
+
+		if (!matchXpathSteps (node, pattern, pattern->count,
+							  pattern->absolute? walk->document: walk->context))
+			continue;
+
+		if (walk->count == walk->size)
+		{
+			walk->size = walk->size? walk->size * 2: 16;
+			walk->matches = xRealloc (walk->matches, walk->size, struct xpathMatch);
+		}
+		walk->matches [walk->count].index = i;
+		walk->matches [walk->count].node = node;
+		walk->count++;
+	}
+}
+
+/* Visit the attributes and the children of PARENT in document order.
+ * DEPTH is the depth of them from the node where the walk starts. */
+static void collectXpathMatches (struct xpathWalk *walk, xmlNode *parent, unsigned int depth)
+{
+	if (walk->maxDepth && depth > walk->maxDepth)
+		return;
+
+	if (parent->type == XML_ELEMENT_NODE)
+	{
+		for (xmlAttr *attr = parent->properties; attr; attr = attr->next)
+			matchXpathPatterns (walk, (xmlNode *)attr);
+	}
+
+	for (xmlNode *child = parent->children; child; child = child->next)
+	{
+		if (child->type == XML_ELEMENT_NODE)
+		{
+			matchXpathPatterns (walk, child);
+			collectXpathMatches (walk, child, depth + 1);
+		}
+		else if (walk->text
+				 && (child->type == XML_TEXT_NODE
+					 || child->type == XML_CDATA_SECTION_NODE))
+			matchXpathPatterns (walk, child);
+	}
+}
+
+/* Decide how deep the walk goes, and whether it visits text nodes.
+ * Return false if no pattern in the table is usable. */
+static bool prepareXpathWalk (struct xpathWalk *walk)
+{
+	const tagXpathTableTable *xpathTableTable = walk->xpathTableTable;
+	bool used = false;
+	bool unlimited = false;
+
+	for (unsigned int i = 0; i < xpathTableTable->count; i++)
+	{
+		const tagXpathTable *elt = xpathTableTable->table + i;
+		const struct sXpathPattern *pattern = elt->xpathPattern;
+		unsigned int depth;
+
+		if (!isXpathPatternUsable (walk, elt))
+			continue;
+
+		used = true;
+		if (pattern->descendant)
+			unlimited = true;
+		if (pattern->text)
+			walk->text = true;
+
+		depth = pattern->count;
+		if (walk->document && !pattern->absolute)
+			depth++;
+		if (depth > walk->maxDepth)
+			walk->maxDepth = depth;
+	}
+
+	if (unlimited)
+		walk->maxDepth = 0;
+
+	return used;
+}
+
+static void walkXpathPatterns (struct xpathWalk *walk, xmlNode *root)
+{
+	/* Absolute patterns are matched only when the walk can start from
+	 * the document node. */
+	if (root->doc && xmlDocGetRootElement (root->doc) == root)
+		walk->document = (xmlNode *)root->doc;
+
+	if (prepareXpathWalk (walk))
+		collectXpathMatches (walk, walk->document? walk->document: root, 1);
+}
 
 static void simpleXpathMakeTag (xmlNode *node,
 				const char *xpath,
@@ -73,11 +451,19 @@ extern void addTagXpath (const langType language CTAGS_ATTR_UNUSED, tagXpathTabl
 {
 	Assert (xpathTable->xpath);
 	Assert (!xpathTable->xpathCompiled);
+	Assert (!xpathTable->xpathPattern);
 
 	verbose ("compile a xpath expression: %s\n", (xmlChar *)xpathTable->xpath);
 	xpathTable->xpathCompiled = xmlXPathCompile ((xmlChar *)xpathTable->xpath);
 	if (!xpathTable->xpathCompiled)
+	{
 		error (WARNING, "Failed to compile the Xpath expression: %s", xpathTable->xpath);
+		return;
+	}
+
+	xpathTable->xpathPattern = compileXpathPattern (xpathTable->xpath);
+	if (!xpathTable->xpathPattern)
+		verbose ("evaluate the xpath expression with libxml2: %s\n", xpathTable->xpath);
 }
 
 extern void removeTagXpath (const langType language CTAGS_ATTR_UNUSED, tagXpathTable *xpathTable)
@@ -87,6 +473,32 @@ extern void removeTagXpath (const langType language CTAGS_ATTR_UNUSED, tagXpathT
 		xmlXPathFreeCompExpr (xpathTable->xpathCompiled);
 		xpathTable->xpathCompiled = NULL;
 	}
+	if (xpathTable->xpathPattern)
+	{
+		freeXpathPattern (xpathTable->xpathPattern);
+		xpathTable->xpathPattern = NULL;
+	}
+}
+
+static void runXpathTableEntry (const tagXpathTable *elt, xmlNode *node,
+								xmlXPathContext *ctx, void *userData)
+{
+	if (elt->specType == LXPATH_TABLE_DO_MAKE)
+		simpleXpathMakeTag (node, elt->xpath, &(elt->spec.makeTagSpec), userData);
+	else
+		elt->spec.recurSpec.enter (node, elt->xpath, &(elt->spec.recurSpec), ctx, userData);
+}
+
+static void runXpathMatches (struct xpathWalk *walk, unsigned int index,
+							 xmlXPathContext *ctx, void *userData)
+{
+	const tagXpathTable *elt = walk->xpathTableTable->table + index;
+
+	for (size_t k = 0; k < walk->count && !isInputBudgetExceeded (); k++)
+	{
+		if (walk->matches [k].index == index)
+			runXpathTableEntry (elt, walk->matches [k].node, ctx, userData);
+	}
 }
 
 static void findXMLTagsCore (xmlXPathContext *ctx, xmlNode *root,
@@ -96,11 +508,22 @@ static void findXMLTagsCore (xmlXPathContext *ctx, xmlNode *root,
 	unsigned int i;
 	int j;
 	xmlNode * node;
+	struct xpathWalk walk = {
+		.xpathTableTable = xpathTableTable,
+		.context = root,
+	};
 
 	Assert (root);
 	Assert (xpathTableTable);
 
-	for (i = 0; i < xpathTableTable->count; ++i)
+	/* Nodes matching the patterns are collected in a walk.
+	 * The tags are made in the order of the table as libxml2
+	 * evaluates the expressions one by one. */
+	walkXpathPatterns (&walk, root);
+
+	/* The tree is walked without reading the input by lines. Stop
+	 * when the parse budget is exceeded in makeTagEntry (). */
+	for (i = 0; i < xpathTableTable->count && !isInputBudgetExceeded (); ++i)
 	{
 		xmlXPathObject *object;
 		xmlNodeSet *set;
@@ -109,6 +532,12 @@ static void findXMLTagsCore (xmlXPathContext *ctx, xmlNode *root,
 		if (! elt->xpathCompiled)
 			continue;
 
+		if (isXpathPatternUsable (&walk, elt))
+		{
+			runXpathMatches (&walk, i, ctx, userData);
+			continue;
+		}
+
 #if 0
 		/* Older version of libxml2 doesn't have xmlXPathSetContextNode. */
 		if (xmlXPathSetContextNode (root, ctx) != 0)
@@ -128,17 +557,17 @@ static void findXMLTagsCore (xmlXPathContext *ctx, xmlNode *root,
 
 		if (set)
 		{
-			for (j = 0; j < xmlXPathNodeSetGetLength (set); ++j)
+			for (j = 0; j < xmlXPathNodeSetGetLength (set) && !isInputBudgetExceeded (); ++j)
 			{
 				node = xmlXPathNodeSetItem(set, j);
-				if (elt->specType == LXPATH_TABLE_DO_MAKE)
-					simpleXpathMakeTag (node, elt->xpath, &(elt->spec.makeTagSpec), userData);
-				else
-					elt->spec.recurSpec.enter (node, elt->xpath, &(elt->spec.recurSpec), ctx, userData);
+				runXpathTableEntry (elt, node, ctx, userData);
 			}
 		}
 		xmlXPathFreeObject (object);
 	}
+
+	if (walk.matches)
+		eFree (walk.matches);
 }
 
 static void suppressWarning (void *ctx CTAGS_ATTR_UNUSED, const char *msg CTAGS_ATTR_UNUSED, ...)
@@ -163,12 +592,158 @@ static xmlDocPtr makeXMLDoc (void)
 	{
 		xmlSetGenericErrorFunc (NULL, suppressWarning);
 		xmlLineNumbersDefault (1);
-		doc = xmlParseMemory((const char*)data, size);
+		/* Small text nodes are stored in their node structures. */
+		doc = xmlReadMemory ((const char*)data, size, NULL, NULL, XML_PARSE_COMPACT);
 	}
 
 	return doc;
 }
 
+#ifdef LIBXML_READER_ENABLED
+/* Can the tables of LANG run on the children of the root element
+ * one by one? Every expression must be a pattern. Only the table
+ * the parser starts from may have absolute patterns; the others are
+ * evaluated from the nodes below the root element. The xpath field
+ * is made from the siblings of the nodes, which are freed or not read
+ * yet. */
+static bool canStreamXpathTables (const langType lang, int tableTableIndex)
+{
+	if (isFieldEnabled (FIELD_XPATH))
+		return false;
+
+	for (unsigned int i = 0; i < getXpathTableTableCount (lang); i++)
+	{
+		const tagXpathTableTable *xpathTableTable = getXpathTableTable (lang, i);
+
+		for (unsigned int j = 0; j < xpathTableTable->count; j++)
+		{
+			const tagXpathTable *elt = xpathTableTable->table + j;
+
+			if (!elt->xpathPattern
+				|| (elt->xpathPattern->absolute && i != (unsigned int)tableTableIndex))
+				return false;
+		}
+	}
+	return true;
+}
+
+static void suppressReaderWarning (void *arg CTAGS_ATTR_UNUSED,
+								   const char *msg CTAGS_ATTR_UNUSED,
+								   xmlParserSeverities severity CTAGS_ATTR_UNUSED,
+								   xmlTextReaderLocatorPtr locator CTAGS_ATTR_UNUSED)
+{
+}
+
+/* Match NODE, a child of the root element, and the nodes under it, and
+ * make tags for them. */
+static void streamXpathNode (struct xpathWalk *walk, xmlNode *node,
+							 xmlXPathContext *ctx, void *userData)
+{
+	const unsigned int depth = 2;	/* from the document node */
+
+	walk->count = 0;
+	if (walk->maxDepth && depth > walk->maxDepth)
+		return;
+
+	if (node->type == XML_ELEMENT_NODE)
+	{
+		matchXpathPatterns (walk, node);
+		collectXpathMatches (walk, node, depth + 1);
+	}
+	else if (walk->text
+			 && (node->type == XML_TEXT_NODE
+				 || node->type == XML_CDATA_SECTION_NODE))
+		matchXpathPatterns (walk, node);
+
+	for (unsigned int i = 0; i < walk->xpathTableTable->count; i++)
+		runXpathMatches (walk, i, ctx, userData);
+}
+
+/* Return false if the input is not read. */
+static bool streamXMLTags (const tagXpathTableTable *xpathTableTable,
+						   void *userData)
+{
+	const unsigned char* data;
+	size_t size;
+	xmlTextReaderPtr reader;
+	xmlDocPtr doc = NULL;
+	xmlXPathContext *ctx = NULL;
+	xmlNode *root = NULL;
+	int r;
+	struct xpathWalk walk = {
+		.xpathTableTable = xpathTableTable,
+	};
+
+	data = getInputFileData (&size);
+	if (data == NULL)
+		return false;
+
+	xmlLineNumbersDefault (1);
+	reader = xmlReaderForMemory ((const char*)data, size, NULL, NULL, 0);
+	if (reader == NULL)
+		return false;
+	xmlTextReaderSetErrorHandler (reader, suppressReaderWarning, NULL);
+
+	verbose ("stream xml doc data\n");
+	r = xmlTextReaderRead (reader);
+	while (r == 1 && !isInputBudgetExceeded ())
+	{
+		int depth = xmlTextReaderDepth (reader);
+		xmlNode *node;
+
+		if (depth == 0 && root == NULL
+			&& xmlTextReaderNodeType (reader) == XML_READER_TYPE_ELEMENT)
+		{
+			/* The root element is read with its attributes and
+			 * namespace declarations, but without its children. */
+			root = xmlTextReaderCurrentNode (reader);
+			/* The reader doesn't free the document once it is taken. */
+			doc = xmlTextReaderCurrentDoc (reader);
+			ctx = xmlXPathNewContext (doc);
+			if (ctx == NULL)
+				error (FATAL, "failed to make a new xpath context for %s", getInputFileName());
+
+			walk.context = root;
+			walk.document = (xmlNode *)doc;
+			if (!prepareXpathWalk (&walk))
+				break;
+
+			matchXpathPatterns (&walk, root);
+			if (root->type == XML_ELEMENT_NODE
+				&& (walk.maxDepth == 0 || walk.maxDepth >= 2))
+			{
+				for (xmlAttr *attr = root->properties; attr; attr = attr->next)
+					matchXpathPatterns (&walk, (xmlNode *)attr);
+			}
+			for (unsigned int i = 0; i < xpathTableTable->count; i++)
+				runXpathMatches (&walk, i, ctx, userData);
+			r = xmlTextReaderRead (reader);
+		}
+		else if (depth == 1 && root
+				 && (node = xmlTextReaderExpand (reader)) != NULL)
+		{
+			streamXpathNode (&walk, node, ctx, userData);
+			/* Skip the subtree; the reader frees it. */
+			r = xmlTextReaderNext (reader);
+		}
+		else
+			r = xmlTextReaderRead (reader);
+	}
+
+	if (r < 0)
+		verbose ("could not parse %s as a XML file\n", getInputFileName());
+
+	if (walk.matches)
+		eFree (walk.matches);
+	if (ctx)
+		xmlXPathFreeContext (ctx);
+	xmlFreeTextReader (reader);
+	if (doc)
+		xmlFreeDoc (doc);
+	return true;
+}
+#endif
+
 extern void findXMLTagsFull (xmlXPathContext *ctx, xmlNode *root,
 			 int tableTableIndex,
 			 void (* runAfter) (xmlXPathContext *, xmlNode *, void *),
@@ -187,6 +762,14 @@ extern void findXMLTagsFull (xmlXPathContext *ctx, xmlNode *root,
 
 		findRegexTags ();
 
+#ifdef LIBXML_READER_ENABLED
+		/* Nothing needs the tree after making tags. */
+		if (runAfter == NULL && getInputFileUserData () == NULL
+			&& canStreamXpathTables (lang, tableTableIndex)
+			&& streamXMLTags (xpathTableTable, userData))
+			return;
+#endif
+
 		doc = makeXMLDoc ();
 
 		if (doc == NULL)
@@ -226,6 +809,7 @@ out:
 extern void addTagXpath (const langType language, tagXpathTable *xpathTable)
 {
 	xpathTable->xpathCompiled = NULL;
+	xpathTable->xpathPattern = NULL;
 }
 
 extern void removeTagXpath (const langType language CTAGS_ATTR_UNUSED, tagXpathTable *xpathTable CTAGS_ATTR_UNUSED)
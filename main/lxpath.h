@@ -72,6 +72,9 @@ typedef struct sTagXpathTable
 		tagXpathRecurSpec   recurSpec;
 	} spec;
 	xmlXPathCompExpr* xpathCompiled;
+	/* Made from xpath when the expression is simple enough for
+	   main/lxpath part to evaluate it without libxml2's xpath engine. */
+	struct sXpathPattern* xpathPattern;
 } tagXpathTable;
 
 typedef struct sTagXpathTableTable {
@@ -59,6 +59,7 @@
 #include "options_p.h"
 #include "parse_p.h"
 #include "read_p.h"
+#include "refs_p.h"
 #include "routines_p.h"
 #include "stats_p.h"
 #include "trace.h"
@@ -376,6 +377,7 @@ static void batchMakeTags (cookedArgs *args, void *user CTAGS_ATTR_UNUSED)
 
 	if ((! Option.filter) && (!Option.printLanguage))
 		closeTagFile (resize);
+	writeReferenceOutput ();
 
 	timeStamp (2);
 
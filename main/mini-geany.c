@@ -13,6 +13,7 @@
 #include "types.h"
 #include "routines.h"
 #include "mio.h"
+#include "vstring.h"
 #include "error_p.h"
 #include "writer_p.h"
 #include "parse_p.h"
@@ -23,6 +24,7 @@
 #include "entry_p.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 
@@ -159,6 +161,34 @@ static char ctagsGetKindFromIndex(int index, int lang)
 }
 
 
+/* we need to be able to get the extras of a tag, like "guest" for the tags
+ * of a guest parser; NULL if the tag has none */
+static char *ctagsGetExtras(const tagEntryInfo *info)
+{
+	vString *extras = vStringNew();
+	int i;
+
+	for (i = 0; i < countXtags(); i++)
+	{
+		const char *name = getXtagName(i);
+
+		if (name && isTagExtraBitMarked(info, i))
+		{
+			if (vStringLength(extras) > 0)
+				vStringPut(extras, ',');
+			vStringCatS(extras, name);
+		}
+	}
+
+	if (vStringLength(extras) == 0)
+	{
+		vStringDelete(extras);
+		return NULL;
+	}
+	return vStringDeleteUnwrap(extras);
+}
+
+
 /* we need to be able to get the number of parsers */
 static unsigned int ctagsGetLangCount(void)
 {
@@ -178,6 +208,7 @@ typedef struct {
 	char *varType;
 	char *access;
 	char *implementation;
+	char *extras;
 	char kindLetter;
 	bool isFileScope;
 	unsigned long lineNumber;
@@ -202,6 +233,7 @@ static Tag *createTag(const tagEntryInfo *info)
 		tag->access = eStrdup(info->extensionFields.access);
 	if (info->extensionFields.implementation)
 		tag->implementation = eStrdup(info->extensionFields.implementation);
+	tag->extras = ctagsGetExtras(info);
 	tag->kindLetter = ctagsGetKindFromIndex(info->kindIndex, info->langType);
 	tag->isFileScope = info->isFileScope;
 	tag->lineNumber = info->lineNumber;
@@ -226,6 +258,8 @@ static void destroyTag(Tag *tag)
 		eFree(tag->access);
 	if (tag->implementation)
 		eFree(tag->implementation);
+	if (tag->extras)
+		eFree(tag->extras);
 	eFree(tag);
 }
 
@@ -278,11 +312,16 @@ static void processCollectedTags(ptrArray *tagArray)
 	for (i = 0; i < num; i++)
 	{
 		Tag *tag = ptrArrayItem(tagArray, i);
-		printf("%s\tline: %lu\tkind: %s\t lang: %s\n",
+		printf("%s\tline: %lu\tkind: %s\t lang: %s",
 			tag->name,
 			tag->lineNumber,
 			ctagsGetKindName(tag->kindLetter, tag->lang),
 			ctagsGetLangName(tag->lang));
+		if (tag->scopeName)
+			printf("\t scope: %s", tag->scopeName);
+		if (tag->extras)
+			printf("\t extras: %s", tag->extras);
+		putchar('\n');
 	}
 
 	/* prepare for the next parsing by clearing the tag array */
@@ -290,6 +329,38 @@ static void processCollectedTags(ptrArray *tagArray)
 }
 
 
+/* parse the lines from START to END of FILENAME again, as Geany does
+ * after the user edits them */
+static void reparseRegion(const char *fileName, int lang,
+						  unsigned long start, unsigned long end,
+						  ptrArray *tagArray)
+{
+	FILE *fp = fopen(fileName, "rb");
+	unsigned char *buffer;
+	long size;
+
+	if (fp == NULL || fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0)
+	{
+		fprintf(stderr, "cannot read %s: %s\n", fileName, strerror(errno));
+		if (fp)
+			fclose(fp);
+		return;
+	}
+	rewind(fp);
+	buffer = xMalloc(size + 1, unsigned char);
+	size = (long)fread(buffer, 1, size, fp);
+	fclose(fp);
+
+	printf("\nReparsing lines %lu-%lu of %s:\n", start, end, fileName);
+	if (parseRawBufferRegion(fileName, buffer, size, lang, &start, &end, tagArray))
+		printf("lines %lu-%lu are reparsed\n", start, end);
+	else
+		printf("cannot reparse\n");
+
+	processCollectedTags(tagArray);
+	eFree(buffer);
+}
+
 extern int main (int argc, char **argv)
 {
 	/* called once when Geany starts */
@@ -303,7 +374,14 @@ extern int main (int argc, char **argv)
 	printf("This parser only parses C files - provide them as arguments on the "
 			"command line or get a hard-coded buffer parsed when no arguments "
 			"are provided\n\n");
-	if (argc == 1)  /* parsing contents of a buffer */
+	if (argc == 6 && strcmp(argv[1], "--reparse") == 0)  /* reparsing a region of a file */
+	{
+		/* mini-geany --reparse LANG START END FILE */
+		reparseRegion(argv[5], ctagsGetNamedLang(argv[2]),
+					  strtoul(argv[3], NULL, 10), strtoul(argv[4], NULL, 10),
+					  tagArray);
+	}
+	else if (argc == 1)  /* parsing contents of a buffer */
 	{
 		char *program = "int foo() {}\n\n int bar() {}\n\n int main() {}\n";
 		int lang = ctagsGetNamedLang("C");
@@ -326,6 +404,18 @@ extern int main (int argc, char **argv)
 		parseRawBuffer("whatever", (unsigned char *)program, strlen(program), lang, tagArray);
 
 		processCollectedTags(tagArray);
+
+		/* after the user edits a line, only the region around the line is
+		 * parsed again; the tags in the region replace the old ones */
+		char *edited = "int foo() {}\n\nint baz() {}\n\nint main() {}\n";
+		unsigned long start = 3, end = 3;
+
+		printf("\nReparsing line 3 of the edited buffer:\n");
+		if (parseRawBufferRegion("whatever", (unsigned char *)edited, strlen(edited),
+								 lang, &start, &end, tagArray))
+			printf("lines %lu-%lu are reparsed\n", start, end);
+
+		processCollectedTags(tagArray);
 	}
 	else  /* parsing contents of a file */
 	{
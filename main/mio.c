@@ -152,6 +152,7 @@ struct _MIO {
 			MIODestroyNotify free_func;
 			bool error;
 			bool eof;
+			MIO *base;			/* non-NULL if this is a view of base */
 		} mem;
 	} impl;
 	MIOUserData udata;
@@ -333,6 +334,7 @@ MIO *mio_new_memory (unsigned char *data,
 		mio->impl.mem.free_func = free_func;
 		mio->impl.mem.eof = false;
 		mio->impl.mem.error = false;
+		mio->impl.mem.base = NULL;
 		mio->refcount = 1;
 		mio->udata.d = NULL;
 		mio->udata.f = NULL;
@@ -357,6 +359,9 @@ MIO *mio_new_memory (unsigned char *data,
  *
  * The function doesn't move the file position of @base.
  *
+ * The copied data is followed by a NUL byte, which is not counted
+ * in the size of new mio.
+ *
  * Free-function: mio_unref()
  *
  */
@@ -384,7 +389,8 @@ MIO *mio_new_mio (MIO *base, long start, long size)
 	if (mio_seek (base, start, SEEK_SET) != 0)
 		return NULL;
 
-	data = xMalloc (size, unsigned char);
+	data = xMalloc (size + 1, unsigned char);
+	data [size] = '\0';
 	r= mio_read (base, data, 1, size);
 	mio_seek (base, original_pos, SEEK_SET);
 
@@ -402,6 +408,52 @@ cleanup:
 	return NULL;
 }
 
+/**
+ * mio_new_view:
+ * @base: The original mio
+ * @start: stream offset of the @base where new mio starts
+ * @size: the length of the data in @base referred by new mio
+ *
+ * Creates a new read-only #MIO object referring to the range of @base
+ * given with @start and @size without copying. -1 for @size means the
+ * range from @start to the end of @base. The new #MIO holds a reference
+ * to @base. Writing to the new #MIO fails.
+ *
+ * If @base is not a memory stream, the data is copied as mio_new_mio()
+ * does.
+ *
+ * <warning><para>@base must not be written while the new #MIO is
+ * alive.</para></warning>
+ *
+ * If @size is larger than the length from @start to the end of
+ * @base, %NULL is returned.
+ *
+ * Free-function: mio_unref()
+ *
+ */
+MIO *mio_new_view (MIO *base, long start, long size)
+{
+	unsigned char *data;
+	size_t base_size;
+	MIO *view;
+
+	data = mio_memory_get_data (base, &base_size);
+	if (data == NULL)
+		return mio_new_mio (base, start, size);
+
+	if (start < 0 || (size_t) start > base_size)
+		return NULL;
+	if (size == -1)
+		size = base_size - start;
+	else if (size < 0 || (size_t) size > base_size - start)
+		return NULL;
+
+	view = mio_new_memory (data + start, size, NULL, NULL);
+	if (view)
+		view->impl.mem.base = mio_ref (base);
+	return view;
+}
+
 /**
  * mio_ref:
  * @mio: A #MIO object
@@ -508,6 +560,9 @@ int mio_unref (MIO *mio)
 			mio->impl.mem.free_func = NULL;
 			mio->impl.mem.eof = false;
 			mio->impl.mem.error = false;
+			if (mio->impl.mem.base)
+				mio_unref (mio->impl.mem.base);
+			mio->impl.mem.base = NULL;
 		}
 		else
 			AssertNotReached ();
@@ -668,6 +723,10 @@ static int mem_try_ensure_space (MIO *mio, size_t n)
 {
 	int success = true;
 
+	/* A view shares its buffer with the base. */
+	if (mio->impl.mem.base)
+		return false;
+
 	if (mio->impl.mem.pos + n > mio->impl.mem.size)
 		success = mem_try_resize (mio, mio->impl.mem.pos + n);
 
@@ -1269,6 +1328,34 @@ int mio_getpos (MIO *mio, MIOPos *pos)
 	return rv;
 }
 
+/**
+ * mio_memory_get_pos:
+ * @mio: A #MIO memory stream
+ * @offset: An offset in the stream
+ * @pos: (out): A #MIOPos object to fill-in
+ *
+ * Fills @pos with the position at @offset in @mio, as mio_getpos() does
+ * after seeking to @offset, but without changing the current position of
+ * the stream.
+ *
+ * Returns: On success, 0 is returned. On error, -1 is returned; @mio is
+ *          not a memory stream, or @offset is out of the stream.
+ */
+int mio_memory_get_pos (MIO *mio, long offset, MIOPos *pos)
+{
+	if (mio->type != MIO_TYPE_MEMORY
+		|| offset < 0 || (size_t) offset > mio->impl.mem.size)
+		return -1;
+
+	pos->type = mio->type;
+	pos->impl.mem = offset;
+#ifdef MIO_DEBUG
+	pos->tag = mio;
+#endif /* MIO_DEBUG */
+
+	return 0;
+}
+
 /**
  * mio_setpos:
  * @mio: A #MIO object
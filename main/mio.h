@@ -124,6 +124,7 @@ MIO *mio_new_memory (unsigned char *data,
 					 MIODestroyNotify free_func);
 
 MIO *mio_new_mio    (MIO *base, long start, long size);
+MIO *mio_new_view   (MIO *base, long start, long size);
 MIO *mio_ref        (MIO *mio);
 
 int mio_unref (MIO *mio);
@@ -154,6 +155,7 @@ long mio_tell (MIO *mio);
 void mio_rewind (MIO *mio);
 int mio_getpos (MIO *mio, MIOPos *pos);
 int mio_setpos (MIO *mio, MIOPos *pos);
+int mio_memory_get_pos (MIO *mio, long offset, MIOPos *pos);
 int mio_flush (MIO *mio);
 
 void  mio_attach_user_data (MIO *mio, void *user_data, MIODestroyNotify user_data_free_func);
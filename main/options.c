@@ -32,6 +32,7 @@
 #include "parse_p.h"
 #include "ptag_p.h"
 #include "routines_p.h"
+#include "tagcache_p.h"
 #include "xtag_p.h"
 #include "param_p.h"
 #include "error_p.h"
@@ -120,6 +121,16 @@ typedef const struct sBooleanOption {
 static bool NonOptionEncountered = false;
 static stringList *OptionFiles;
 
+/* Nesting level of option files being parsed */
+static unsigned int OptionFileDepth;
+
+/* --_config-snapshot */
+static char *ConfigSnapshotFile;
+static struct {
+	vString *files;
+	vString *options;
+} ConfigSnapshotRecord;
+
 typedef stringList searchPathList;
 static searchPathList *OptlibPathList;
 
@@ -162,8 +173,11 @@ optionValues Option = {
 	.followLinks = true,
 	.filter = false,
 	.filterTerminator = NULL,
+	.cacheDir = NULL,
+	.refsOutput = NULL,
 	.tagRelative = TREL_NO,
 	.printTotals = 0,
+	.trigramIndex = false,
 	.lineDirectives = false,
 	.printLanguage =false,
 	.guessLanguageEagerly = false,
@@ -172,6 +186,10 @@ optionValues Option = {
 	.patternLengthLimit = 96,
 	.putFieldPrefix = false,
 	.maxRecursionDepth = 0xffffffff,
+	.maxFileSize = 0,
+	.maxParseTime = 0,
+	.maxTagsPerFile = 0,
+	.generatedFiles = GENERATED_FILES_PARSE,
 	.interactive = false,
 #ifdef WIN32
 	.useSlashAsFilenameSeparator = FILENAME_SEP_UNSET,
@@ -241,6 +259,9 @@ static optionDescription LongOptionDescription [] = {
  {1,"       for LANG."},
  {1,"  --append=[yes|no]"},
  {1,"       Should tags should be appended to existing tag file [no]?"},
+ {1,"  --cache-dir=dir"},
+ {1,"       Store tags for each input file in 'dir', and reuse them when the"},
+ {1,"       same input file is tagged with the same options again."},
  {1,"  --etags-include=file"},
  {1,"       Include reference to 'file' in Emacs-style tag file (requires -e)."},
  {1,"  --exclude=pattern"},
@@ -277,6 +298,9 @@ static optionDescription LongOptionDescription [] = {
 #else
  {0,"       Force output of specified tag file format [2]."},
 #endif
+ {1,"  --generated-files=[parse|fast|skip]"},
+ {1,"       Specify how to handle minified or generated input files [parse]."},
+ {1,"       fast: use line numbers instead of patterns for their tags; skip: skip them."},
  {1,"  --guess-language-eagerly"},
  {1,"       Guess the language of input file more eagerly"},
  {1,"       (but taking longer time for guessing):"},
@@ -363,6 +387,14 @@ static optionDescription LongOptionDescription [] = {
  {1,"       Unlike --langmap, this doesn't take a list; only one file name pattern"},
  {1,"       or one file extension can be specified at once."},
  {1,"       Unlike --langmap the change with this option affects mapping of <LANG> only."},
+ {1,"  --max-file-size=N"},
+ {1,"       Skip input files larger than N bytes. 0 means no limit [0]."},
+ {1,"  --max-parse-time=N"},
+ {1,"       Abort parsing an input file after N seconds of CPU time, and discard"},
+ {1,"       the tags for the file. 0 means no limit [0]."},
+ {1,"  --max-tags-per-file=N"},
+ {1,"       Abort parsing an input file when more than N tags are made for it, and"},
+ {1,"       discard the tags for the file. 0 means no limit [0]."},
  {1,"  --maxdepth=N"},
 #ifdef RECURSE_SUPPORTED
  {1,"       Specify maximum recursion depth."},
@@ -410,6 +442,9 @@ static optionDescription LongOptionDescription [] = {
 #else
  {1,"       Not supported on this platform."},
 #endif
+ {1,"  --refs-output=file"},
+ {1,"       Write reference tags to 'file' in a compact binary format instead of"},
+ {1,"       writing them to the tag file."},
  {1,"  --regex-<LANG>=/line_pattern/name_pattern/[flags]"},
  {1,"       Define regular expression for locating tags in specific language."},
  {1,"  --roles-<LANG>.kind=[+|-]role, or"},
@@ -422,6 +457,8 @@ static optionDescription LongOptionDescription [] = {
  {0,"       never:  be absolute even if input files are passed in with relative paths" },
  {1,"  --totals=[yes|no|extra]"},
  {1,"       Print statistics about input and tag files [no]."},
+ {1,"  --trigram-index=[yes|no]"},
+ {1,"       Write an index for substring search of tag names to <tagfile>.tri [no]."},
 #ifdef WIN32
  {1,"  --use-slash-as-filename-separator=[yes|no]"},
  {1,"       Use slash as filename separator [yes] for u-ctags output format."},
@@ -441,6 +478,10 @@ static optionDescription LongOptionDescription [] = {
 static optionDescription ExperimentalLongOptionDescription [] = {
  {1,"  --_anonhash=fname"},
  {1,"       Used in u-ctags test harness"},
+ {1,"  --_config-snapshot=file"},
+ {1,"       Record the options read from preload option files to 'file', and"},
+ {1,"       load them from 'file' in later runs while the files are unchanged."},
+ {1,"       Must be given before any other options except -V and --quiet."},
  {1,"  --_dump-keywords"},
  {1,"       Dump keywords of initialized parser(s)."},
  {1,"  --_dump-options"},
@@ -567,6 +608,9 @@ static struct Feature {
 #ifdef ENABLE_GCOV
 	{"gcov", "linked with code for coverage analysis"},
 #endif
+#ifdef HAVE_USDT
+	{"usdt", "has statically defined tracepoints"},
+#endif
 #ifdef HAVE_PACKCC
 	/* The test harnesses use this as hints for skipping test cases */
 	{"packcc", "has peg based parser(s)"},
@@ -592,6 +636,7 @@ static const char *const StageDescription [] = {
 *   FUNCTION PROTOTYPES
 */
 static bool parseFileOptions (const char *const fileName);
+static void recordFileForConfigSnapshot (const char *const fileName);
 static bool parseAllConfigurationFilesOptionsInDirectory (const char *const fileName,
 							     stringList* const already_loaded_files);
 static bool getBooleanOption (const char *const option, const char *const parameter);
@@ -1405,6 +1450,34 @@ static void processFieldsOption (
 	}
 }
 
+static void processCacheDirOption (
+		const char *const option, const char *const parameter)
+{
+	freeString (&Option.cacheDir);
+
+	if (parameter == NULL || parameter[0] == '\0')
+		return;
+
+	fileStatus *status = eStat (parameter);
+	bool isDirectory = status->exists && status->isDirectory;
+	eStatFree (status);
+	if (!isDirectory)
+		error (FATAL, "No such directory for \"%s\" option: %s", option, parameter);
+
+	Option.cacheDir = stringCopy (parameter);
+}
+
+static void processRefsOutputOption (
+		const char *const option CTAGS_ATTR_UNUSED, const char *const parameter)
+{
+	freeString (&Option.refsOutput);
+
+	if (parameter == NULL || parameter[0] == '\0')
+		return;
+
+	Option.refsOutput = stringCopy (parameter);
+}
+
 static void processFilterTerminatorOption (
 		const char *const option CTAGS_ATTR_UNUSED, const char *const parameter)
 {
@@ -2481,6 +2554,19 @@ static void processSortOption (
 		error (FATAL, "Invalid value for \"%s\" option", option);
 }
 
+static void processGeneratedFilesOption (
+		const char *const option, const char *const parameter)
+{
+	if (strcmp (parameter, "parse") == 0)
+		Option.generatedFiles = GENERATED_FILES_PARSE;
+	else if (strcmp (parameter, "fast") == 0)
+		Option.generatedFiles = GENERATED_FILES_FAST;
+	else if (strcmp (parameter, "skip") == 0)
+		Option.generatedFiles = GENERATED_FILES_SKIP;
+	else
+		error (FATAL, "Invalid value for \"%s\" option", option);
+}
+
 static void processTagRelative (
 		const char *const option, const char *const parameter)
 {
@@ -2628,6 +2714,14 @@ static void processEchoOption (const char *const option, const char *const param
 	notice ("%s", parameter);
 }
 
+static void processConfigSnapshotOption (const char *const option,
+										const char *const parameter CTAGS_ATTR_UNUSED)
+{
+	/* Handled in previewFirstOption () if given at the right place. */
+	error (WARNING, "\"--%s\" option is ignored; it must be given before other options",
+		   option);
+}
+
 static void processForceInitOption (const char *const option CTAGS_ATTR_UNUSED,
 				    const char *const parameter CTAGS_ATTR_UNUSED)
 {
@@ -2755,6 +2849,33 @@ static void processMaxRecursionDepthOption (const char *const option, const char
 	Option.maxRecursionDepth = atol(parameter);
 }
 
+static void processMaxFileSizeOption (const char *const option, const char *const parameter)
+{
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	if (!strToULong (parameter, 0, &Option.maxFileSize))
+		error (FATAL, "-%s: Invalid maximum file size", option);
+}
+
+static void processMaxParseTimeOption (const char *const option, const char *const parameter)
+{
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	if (!strToUInt (parameter, 0, &Option.maxParseTime))
+		error (FATAL, "-%s: Invalid maximum parse time", option);
+}
+
+static void processMaxTagsPerFileOption (const char *const option, const char *const parameter)
+{
+	if (parameter == NULL || parameter[0] == '\0')
+		error (FATAL, "A parameter is needed after \"%s\" option", option);
+
+	if (!strToULong (parameter, 0, &Option.maxTagsPerFile))
+		error (FATAL, "-%s: Invalid maximum number of tags", option);
+}
+
 static void processPatternLengthLimit(const char *const option, const char *const parameter)
 {
 	if (parameter == NULL || parameter[0] == '\0')
@@ -2801,6 +2922,7 @@ static void setBooleanToXtagWithWarning(booleanOption *const option, bool value)
 static void processDumpOptionsOption (const char *const option, const char *const parameter);
 
 static parametricOption ParametricOptions [] = {
+	{ "cache-dir",              processCacheDirOption,          false,  STAGE_ANY },
 	{ "etags-include",          processEtagsInclude,            false,  STAGE_ANY },
 	{ "exclude",                processExcludeOption,           false,  STAGE_ANY },
 	{ "exclude-exception",      processExcludeExceptionOption,  false,  STAGE_ANY },
@@ -2810,6 +2932,7 @@ static parametricOption ParametricOptions [] = {
 	{ "fields",                 processFieldsOption,            false,  STAGE_ANY },
 	{ "filter-terminator",      processFilterTerminatorOption,  true,   STAGE_ANY },
 	{ "format",                 processFormatOption,            true,   STAGE_ANY },
+	{ "generated-files",        processGeneratedFilesOption,    true,   STAGE_ANY },
 	{ "help",                   processHelpOption,              true,   STAGE_ANY },
 	{ "help-full",              processHelpFullOption,          true,   STAGE_ANY },
 	{ "if0",                    processIf0Option,               false,  STAGE_ANY },
@@ -2841,6 +2964,9 @@ static parametricOption ParametricOptions [] = {
 	{ "list-regex-flags",       processListRegexFlagsOptions,   true,   STAGE_ANY },
 	{ "list-roles",             processListRolesOptions,        true,   STAGE_ANY },
 	{ "list-subparsers",        processListSubparsersOptions,   true,   STAGE_ANY },
+	{ "max-file-size",          processMaxFileSizeOption,       true,   STAGE_ANY },
+	{ "max-parse-time",         processMaxParseTimeOption,      true,   STAGE_ANY },
+	{ "max-tags-per-file",      processMaxTagsPerFileOption,    true,   STAGE_ANY },
 	{ "maxdepth",               processMaxRecursionDepthOption, true,   STAGE_ANY },
 	{ "optlib-dir",             processOptlibDir,               false,  STAGE_ANY },
 	{ "options",                processOptionFile,              false,  STAGE_ANY },
@@ -2848,11 +2974,13 @@ static parametricOption ParametricOptions [] = {
 	{ "output-format",          processOutputFormat,            true,   STAGE_ANY },
 	{ "pattern-length-limit",   processPatternLengthLimit,      true,   STAGE_ANY },
 	{ "pseudo-tags",            processPseudoTags,              false,  STAGE_ANY },
+	{ "refs-output",            processRefsOutputOption,        false,  STAGE_ANY },
 	{ "sort",                   processSortOption,              true,   STAGE_ANY },
 	{ "tag-relative",           processTagRelative,             true,   STAGE_ANY },
 	{ "totals",                 processTotals,                  true,   STAGE_ANY },
 	{ "version",                processVersionOption,           true,   STAGE_ANY },
 	{ "_anonhash",              processAnonHashOption,          false,  STAGE_ANY },
+	{ "_config-snapshot",       processConfigSnapshotOption,    false,  STAGE_ANY },
 	{ "_dump-keywords",         processDumpKeywordsOption,      false,  STAGE_ANY },
 	{ "_dump-options",          processDumpOptionsOption,       false,  STAGE_ANY },
 	{ "_echo",                  processEchoOption,              false,  STAGE_ANY },
@@ -2885,6 +3013,7 @@ static booleanOption BooleanOptions [] = {
 #ifdef RECURSE_SUPPORTED
 	{ "recurse",        &Option.recurse,                false, STAGE_ANY },
 #endif
+	{ "trigram-index",  &Option.trigramIndex,           true,  STAGE_ANY },
 	{ "verbose",        &ctags_verbose,                false, STAGE_ANY },
 #ifdef WIN32
 	{ "use-slash-as-filename-separator", (bool *)&Option.useSlashAsFilenameSeparator, false, STAGE_ANY },
@@ -3435,20 +3564,46 @@ static void processShortOption (
 	}
 }
 
+static void recordOptionForConfigSnapshot (bool longOption,
+											const char *const item, const char *const parameter)
+{
+	/* Options in a file loaded with --options in an option file are
+	 * not recorded. The --options itself is recorded instead. */
+	if (ConfigSnapshotRecord.options == NULL || OptionFileDepth != 1)
+		return;
+
+	vStringCatS (ConfigSnapshotRecord.options, "O\t");
+	vStringCatS (ConfigSnapshotRecord.options, StageDescription[Stage]);
+	vStringPut (ConfigSnapshotRecord.options, '\t');
+	vStringPut (ConfigSnapshotRecord.options, longOption? 'l': 's');
+	vStringPut (ConfigSnapshotRecord.options, '\t');
+	vStringCatS (ConfigSnapshotRecord.options, item);
+	vStringPut (ConfigSnapshotRecord.options, '\t');
+	vStringCatS (ConfigSnapshotRecord.options, parameter);
+	vStringPut (ConfigSnapshotRecord.options, '\n');
+}
+
+static void applyOption (bool longOption, const char *const item, const char *const parameter)
+{
+	recordOptionForConfigSnapshot (longOption, item, parameter);
+	updateTagCacheFingerprint (longOption, item, parameter);
+	if (longOption)
+		processLongOption (item, parameter);
+	else
+	{
+		const char *p = parameter;
+		while (*p == ' ')
+			++p;
+		processShortOption (item, p);
+	}
+}
+
 static void parseOption (cookedArgs* const args)
 {
 	Assert (! cArgOff (args));
 	if (args->isOption)
 	{
-		if (args->longOption)
-			processLongOption (args->item, args->parameter);
-		else
-		{
-			const char *parameter = args->parameter;
-			while (*parameter == ' ')
-				++parameter;
-			processShortOption (args->item, parameter);
-		}
+		applyOption (args->longOption, args->item, args->parameter);
 		cArgForth (args);
 	}
 }
@@ -3492,7 +3647,11 @@ static bool parseFileOptions (const char* const fileName)
 			vString* file = vStringNewInit (fileName);
 			stringListAdd (OptionFiles, file);
 			verbose (format, fileName, "reading...");
+			if (ConfigSnapshotRecord.files && OptionFileDepth == 0)
+				recordFileForConfigSnapshot (fileName);
+			OptionFileDepth++;
 			parseOptions (args);
+			OptionFileDepth--;
 			if (NonOptionEncountered)
 				error (WARNING, "Ignoring non-option in %s\n", fileName);
 			cArgDelete (args);
@@ -3519,6 +3678,15 @@ extern void previewFirstOption (cookedArgs* const args)
 			SkipConfiguration = true;
 			cArgForth (args);
 		}
+		else if (strcmp (args->item, "_config-snapshot") == 0)
+		{
+			if (ConfigSnapshotFile)
+				eFree (ConfigSnapshotFile);
+			ConfigSnapshotFile = (args->parameter[0] == '\0')
+				? NULL
+				: eStrdup (args->parameter);
+			cArgForth (args);
+		}
 		else
 			break;
 	}
@@ -3756,9 +3924,297 @@ static struct preloadPathElt preload_path_list [] = {
 	},
 };
 
+/*
+ *  Config snapshot
+ *
+ *  With --_config-snapshot=FILE, the options read from the preload
+ *  files are recorded to FILE. In the next run, the options are taken
+ *  from FILE in one read instead of scanning the directories and
+ *  reading the files, as long as none of them is changed.
+ *
+ *  FILE is a text file:
+ *
+ *    !_CTAGS_CONFIG_SNAPSHOT<TAB>version<TAB>program-version
+ *    P<TAB>stage<TAB>mtime<TAB>path       a preload file or directory
+ *    F<TAB>mtime<TAB>size<TAB>path        a file read in preloading
+ *    O<TAB>stage<TAB>l|s<TAB>item<TAB>parameter
+ *
+ *  mtime is seconds.nanoseconds, or -1 if the path doesn't exist. The
+ *  nanoseconds are 0 on the platforms not having them. Adding or
+ *  removing a file in a directory changes the mtime of the directory.
+ */
+#define CONFIG_SNAPSHOT_MAGIC   "!_CTAGS_CONFIG_SNAPSHOT"
+#define CONFIG_SNAPSHOT_VERSION 2
+
+static void catFileStatusForConfigSnapshot (vString *buf, const char *const path, bool withSize)
+{
+	fileStatus *status = eStat (path);
+	char tmp [64];
+
+	if (status->exists && withSize)
+		snprintf (tmp, sizeof (tmp), "%lld.%09ld\t%lu\t",
+				  (long long)status->mtime, status->mtimeNsec, status->size);
+	else if (status->exists)
+		snprintf (tmp, sizeof (tmp), "%lld.%09ld\t",
+				  (long long)status->mtime, status->mtimeNsec);
+	else
+		snprintf (tmp, sizeof (tmp), withSize? "-1\t0\t": "-1\t");
+	eStatFree (status);
+
+	vStringCatS (buf, tmp);
+	vStringCatS (buf, path);
+	vStringPut (buf, '\n');
+}
+
+static void recordFileForConfigSnapshot (const char *const fileName)
+{
+	vStringCatS (ConfigSnapshotRecord.files, "F\t");
+	catFileStatusForConfigSnapshot (ConfigSnapshotRecord.files, fileName, true);
+}
+
+/* Make the part of the snapshot telling where ctags looks for
+ * preload files. */
+static vString *makeConfigSnapshotKey (struct preloadPathElt *pathList)
+{
+	vString *key = vStringNew ();
+
+	vStringCatS (key, CONFIG_SNAPSHOT_MAGIC);
+	vStringPut (key, '\t');
+	vStringCatS (key, STRINGIFY (CONFIG_SNAPSHOT_VERSION));
+	vStringPut (key, '\t');
+	vStringCatS (key, PROGRAM_VERSION);
+	vStringPut (key, '\n');
+
+	for (unsigned int i = 0; pathList[i].path != NULL || pathList[i].makePath != NULL; ++i)
+	{
+		struct preloadPathElt *elt = pathList + i;
+		const char *path = elt->makePath
+			? elt->makePath (elt->path, elt->extra)
+			: elt->path;
+
+		if (path == NULL)
+			continue;
+
+		vStringCatS (key, "P\t");
+		vStringCatS (key, StageDescription[elt->stage]);
+		vStringPut (key, '\t');
+		catFileStatusForConfigSnapshot (key, path, false);
+
+		if (path != elt->path)
+			eFree ((void *)path);
+	}
+
+	return key;
+}
+
+static char *readConfigSnapshot (size_t *length)
+{
+	FILE *fp = fopen (ConfigSnapshotFile, "rb");
+	char *data = NULL;
+	long size;
+
+	if (fp == NULL)
+		return NULL;
+
+	if (fseek (fp, 0, SEEK_END) == 0
+		&& (size = ftell (fp)) > 0
+		&& fseek (fp, 0, SEEK_SET) == 0)
+	{
+		data = eMalloc (size + 1);
+		if (fread (data, 1, size, fp) != (size_t)size)
+		{
+			eFree (data);
+			data = NULL;
+		}
+		else
+		{
+			data [size] = '\0';
+			*length = size;
+		}
+	}
+	fclose (fp);
+	return data;
+}
+
+static OptionLoadingStage stageForDescription (const char *const desc)
+{
+	for (unsigned int i = 0; i < ARRAY_SIZE (StageDescription); i++)
+	{
+		if (StageDescription[i] && strcmp (StageDescription[i], desc) == 0)
+			return i;
+	}
+	return OptionLoadingStageNone;
+}
+
+/* Split LINE at tabs into at most N fields. The last field takes
+ * the rest of the line. */
+static unsigned int splitConfigSnapshotLine (char *line, char **fields, unsigned int n)
+{
+	unsigned int i = 0;
+
+	fields [i++] = line;
+	while (i < n)
+	{
+		char *tab = strchr (line, '\t');
+		if (tab == NULL)
+			break;
+		*tab = '\0';
+		line = tab + 1;
+		fields [i++] = line;
+	}
+	return i;
+}
+
+/* ENTRY is "mtime<TAB>size<TAB>path" of an F line. */
+static bool isConfigSnapshotFileUpToDate (const char *const entry, const char **path)
+{
+	const char *p = strchr (entry, '\t');
+	vString *status;
+	bool r;
+
+	if (p == NULL || (p = strchr (p + 1, '\t')) == NULL)
+		return false;
+	*path = p + 1;
+
+	status = vStringNew ();
+	catFileStatusForConfigSnapshot (status, *path, true);
+	vStringChop (status);		/* '\n' */
+	r = (strcmp (vStringValue (status), entry) == 0);
+	vStringDelete (status);
+	return r;
+}
+
+static bool loadConfigSnapshot (struct preloadPathElt *pathList)
+{
+	size_t length;
+	char *data = readConfigSnapshot (&length);
+	vString *key;
+	char *line, *next;
+	const char *path;
+	bool r = false;
+
+	if (data == NULL)
+		return false;
+
+	key = makeConfigSnapshotKey (pathList);
+	if (length < vStringLength (key)
+		|| strncmp (data, vStringValue (key), vStringLength (key)) != 0)
+	{
+		verbose ("Config snapshot %s: out of date\n", ConfigSnapshotFile);
+		goto out;
+	}
+
+	/* Verify all files before applying any option. */
+	for (line = data + vStringLength (key); *line; line = next)
+	{
+		char *nl = strchr (line, '\n');
+		if (nl == NULL)
+			goto broken;
+		next = nl + 1;
+
+		if (line[0] == 'O')
+			break;
+		else if (line[0] != 'F' || line[1] != '\t')
+			goto broken;
+
+		*nl = '\0';
+		path = NULL;
+		if (!isConfigSnapshotFileUpToDate (line + 2, &path))
+		{
+			verbose ("Config snapshot %s: %s is changed\n",
+					 ConfigSnapshotFile, path? path: "a file");
+			goto out;
+		}
+		stringListAdd (OptionFiles, vStringNewInit (path));
+	}
+
+	verbose ("Config snapshot %s: loading\n", ConfigSnapshotFile);
+	for (; *line; line = next)
+	{
+		char *fields [5];
+		OptionLoadingStage stage;
+		char *nl = strchr (line, '\n');
+
+		if (nl == NULL)
+			goto broken;
+		*nl = '\0';
+		next = nl + 1;
+
+		if (splitConfigSnapshotLine (line, fields, 5) != 5
+			|| strcmp (fields[0], "O") != 0
+			|| (stage = stageForDescription (fields[1])) == OptionLoadingStageNone)
+			goto broken;
+
+		Assert (Stage <= stage);
+		if (Stage != stage)
+		{
+			Stage = stage;
+			verbose ("Entering configuration stage: loading %s\n", StageDescription[Stage]);
+		}
+		applyOption (fields[2][0] == 'l', fields[3], fields[4]);
+	}
+	r = true;
+	goto out;
+
+ broken:
+	error (WARNING, "broken config snapshot: %s", ConfigSnapshotFile);
+ out:
+	vStringDelete (key);
+	eFree (data);
+	return r;
+}
+
+static void storeConfigSnapshot (struct preloadPathElt *pathList)
+{
+	vString *key = makeConfigSnapshotKey (pathList);
+	char *tempName = NULL;
+	FILE *fp = openFileForReplacing (ConfigSnapshotFile, &tempName);
+	bool r;
+
+	/* The snapshot is renamed into place after it is written so that
+	 * another ctags process never loads a partially written one. */
+	if (fp == NULL)
+		error (WARNING | PERROR, "cannot open config snapshot: %s", ConfigSnapshotFile);
+	else
+	{
+		r = (fputs (vStringValue (key), fp) != EOF
+			 && fputs (vStringValue (ConfigSnapshotRecord.files), fp) != EOF
+			 && fputs (vStringValue (ConfigSnapshotRecord.options), fp) != EOF);
+		if (fclose (fp) == EOF)
+			r = false;
+		if (!r)
+		{
+			error (WARNING | PERROR, "failed to write config snapshot: %s", ConfigSnapshotFile);
+			remove (tempName);
+		}
+		else if (!replaceFile (tempName, ConfigSnapshotFile))
+			error (WARNING | PERROR, "cannot rename config snapshot: %s", ConfigSnapshotFile);
+		eFree (tempName);
+	}
+	vStringDelete (key);
+}
+
 static void parseConfigurationFileOptions (void)
 {
+	if (ConfigSnapshotFile == NULL)
+	{
+		preload (preload_path_list);
+		return;
+	}
+
+	if (loadConfigSnapshot (preload_path_list))
+		return;
+
+	ConfigSnapshotRecord.files = vStringNew ();
+	ConfigSnapshotRecord.options = vStringNew ();
+
 	preload (preload_path_list);
+	storeConfigSnapshot (preload_path_list);
+
+	vStringDelete (ConfigSnapshotRecord.files);
+	ConfigSnapshotRecord.files = NULL;
+	vStringDelete (ConfigSnapshotRecord.options);
+	ConfigSnapshotRecord.options = NULL;
 }
 
 static void parseEnvironmentOptions (void)
@@ -3883,6 +4339,8 @@ extern void freeOptionResources (void)
 	freeString (&Option.tagFileName);
 	freeString (&Option.fileList);
 	freeString (&Option.filterTerminator);
+	freeString (&Option.cacheDir);
+	freeString (&Option.refsOutput);
 
 	freeList (&Excluded);
 	freeList (&ExcludedException);
@@ -3892,6 +4350,12 @@ extern void freeOptionResources (void)
 	freeSearchPathList (&OptlibPathList);
 
 	freeList (&OptionFiles);
+
+	if (ConfigSnapshotFile)
+	{
+		eFree (ConfigSnapshotFile);
+		ConfigSnapshotFile = NULL;
+	}
 }
 
 static void processDumpOptionsOption (const char *const option CTAGS_ATTR_UNUSED, const char *const parameter CTAGS_ATTR_UNUSED)
@@ -3910,6 +4374,13 @@ extern bool inSandbox (void)
 	return (Option.interactive == INTERACTIVE_SANDBOX);
 }
 
+/* True while the options given on the command line, including the ones
+ * in files given with --options there, are processed. */
+extern bool isProcessingCommandLineOptions (void)
+{
+	return (Stage == OptionLoadingStageCmdline);
+}
+
 extern bool canUseLineNumberAsLocator (void)
 {
 	return (Option.locate != EX_PATTERN);
@@ -70,6 +70,12 @@ typedef enum eTagRelative {
 	TREL_NEVER,
 } tagRelative;
 
+typedef enum eGeneratedFiles {
+	GENERATED_FILES_PARSE,
+	GENERATED_FILES_FAST,
+	GENERATED_FILES_SKIP,
+} generatedFiles;
+
 typedef enum eOptionLoadingStage {
 	OptionLoadingStageNone,
 	OptionLoadingStageCustom,
@@ -108,8 +114,11 @@ typedef struct sOptionValues {
 	bool followLinks;    /* --link  follow symbolic links? */
 	bool filter;         /* --filter  behave as filter: files in, tags out */
 	char* filterTerminator; /* --filter-terminator  string to output */
+	char* cacheDir;         /* --cache-dir  directory for caching tags of input files */
+	char* refsOutput;       /* --refs-output  file for writing reference tags */
 	tagRelative tagRelative;    /* --tag-relative file paths relative to tag file */
 	int  printTotals;    /* --totals  print cumulative statistics */
+	bool trigramIndex;   /* --trigram-index  write trigram index of tag names */
 	bool lineDirectives; /* --linedirectives  process #line directives */
 	bool printLanguage;  /* --print-language */
 	bool guessLanguageEagerly; /* --guess-language-eagerly|-G */
@@ -118,6 +127,10 @@ typedef struct sOptionValues {
 	unsigned int patternLengthLimit; /* --pattern-length-limit=N */
 	bool putFieldPrefix;		 /* --put-field-prefix */
 	unsigned int maxRecursionDepth; /* --maxdepth=<max-recursion-depth> */
+	unsigned long maxFileSize;    /* --max-file-size=N */
+	unsigned int maxParseTime;    /* --max-parse-time=N */
+	unsigned long maxTagsPerFile; /* --max-tags-per-file=N */
+	generatedFiles generatedFiles; /* --generated-files */
 	enum interactiveMode { INTERACTIVE_NONE = 0,
 						   INTERACTIVE_DEFAULT,
 						   INTERACTIVE_SANDBOX, } interactive; /* --interactive */
@@ -191,6 +204,7 @@ extern bool processPretendOption (const char *const option, const char *const pa
 extern bool processRolesOption (const char *const option, const char *const parameter);
 
 extern bool isDestinationStdout (void);
+extern bool isProcessingCommandLineOptions (void);
 
 extern void setMainLoop (mainLoopFunc func, void *data);
 
@@ -19,29 +19,35 @@
 
 #include <string.h>
 
+#include "budget_p.h"
 #include "ctags.h"
 #include "debug.h"
 #include "entry_p.h"
 #include "field_p.h"
 #include "flags_p.h"
+#include "generated_p.h"
 #include "htable.h"
 #include "keyword.h"
+#include "keyword_p.h"
 #include "lxpath_p.h"
 #include "param.h"
 #include "param_p.h"
 #include "parse_p.h"
 #include "parsers_p.h"
+#include "probe_p.h"
 #include "promise.h"
 #include "promise_p.h"
 #include "ptag_p.h"
 #include "ptrarray.h"
 #include "read.h"
 #include "read_p.h"
+#include "refs_p.h"
 #include "routines.h"
 #include "routines_p.h"
 #include "stats_p.h"
 #include "subparser.h"
 #include "subparser_p.h"
+#include "tagcache_p.h"
 #include "trace.h"
 #include "trashbox.h"
 #include "trashbox_p.h"
@@ -1041,10 +1047,25 @@ static vString* extractPHPMark(MIO* input)
 }
 
 
+/* Tasters look at the head or the tail of the input. The parts are read
+ * only once for an input file and shared by the tasters.
+ * PEEK_TAIL_SIZE must be larger than the 3000 bytes in which Emacs looks
+ * for the local variables list. */
+#define PEEK_HEAD_SIZE 4096
+#define PEEK_TAIL_SIZE 4096
+
 struct getLangCtx {
     const char *fileName;
     MIO        *input;
     bool     err;
+
+    bool     peeked;
+    unsigned char *head;
+    size_t         headLength;
+    unsigned char *tail;
+    size_t         tailLength;
+    bool           tailIsWhole;	/* tail starts from the beginning of input */
+    unsigned char *peekBuffer;	/* owned copy used if input is not on memory */
 };
 
 #define GLC_FOPEN_IF_NECESSARY0(_glc_, _label_) do {        \
@@ -1079,36 +1100,143 @@ struct getLangCtx {
         mio_unref((_glc_)->input);                             \
         (_glc_)->input = NULL;                              \
     }                                                       \
+    if ((_glc_)->peekBuffer) {                              \
+        eFree ((_glc_)->peekBuffer);                        \
+        (_glc_)->peekBuffer = NULL;                         \
+    }                                                       \
 } while (0)
 
+static void peekInput (struct getLangCtx *glc)
+{
+	unsigned char *data;
+	size_t size;
+	long fileSize;
+
+	if (glc->peeked)
+		return;
+	glc->peeked = true;
+
+	data = mio_memory_get_data (glc->input, &size);
+	if (data)
+	{
+		/* No copy is needed. */
+		glc->head = data;
+		glc->headLength = (size < PEEK_HEAD_SIZE)? size: PEEK_HEAD_SIZE;
+		glc->tailIsWhole = (size <= PEEK_TAIL_SIZE);
+		glc->tail = glc->tailIsWhole? data: data + size - PEEK_TAIL_SIZE;
+		glc->tailLength = glc->tailIsWhole? size: PEEK_TAIL_SIZE;
+		return;
+	}
+
+	glc->peekBuffer = xMalloc (PEEK_HEAD_SIZE + PEEK_TAIL_SIZE, unsigned char);
+	glc->head = glc->peekBuffer;
+	glc->tail = glc->peekBuffer;
+	glc->tailIsWhole = true;
+
+	if (mio_seek (glc->input, 0, SEEK_END) != 0
+		|| (fileSize = mio_tell (glc->input)) < 0)
+		goto out;
+
+	if (fileSize <= PEEK_HEAD_SIZE)
+	{
+		mio_rewind (glc->input);
+		glc->headLength = mio_read (glc->input, glc->head, 1, fileSize);
+		glc->tailLength = glc->headLength;
+		goto out;
+	}
+
+	mio_rewind (glc->input);
+	glc->headLength = mio_read (glc->input, glc->head, 1, PEEK_HEAD_SIZE);
+
+	glc->tail = glc->peekBuffer + PEEK_HEAD_SIZE;
+	glc->tailIsWhole = (fileSize <= PEEK_TAIL_SIZE);
+	if (mio_seek (glc->input, glc->tailIsWhole? 0: fileSize - PEEK_TAIL_SIZE,
+				  SEEK_SET) == 0)
+		glc->tailLength = mio_read (glc->input, glc->tail, 1,
+									glc->tailIsWhole? fileSize: PEEK_TAIL_SIZE);
+
+ out:
+	mio_rewind (glc->input);
+}
+
+enum tasteRange {
+	TASTE_HEAD,			/* the first PEEK_HEAD_SIZE bytes */
+	TASTE_TAIL,			/* the last PEEK_TAIL_SIZE bytes */
+	TASTE_TAIL_LINES,	/* TASTE_TAIL without the leading partial line */
+};
+
+static MIO *newPeekMio (struct getLangCtx *glc, enum tasteRange range)
+{
+	unsigned char *data;
+	size_t length;
+
+	peekInput (glc);
+
+	switch (range)
+	{
+	case TASTE_HEAD:
+		data = glc->head;
+		length = glc->headLength;
+		break;
+	case TASTE_TAIL_LINES:
+		data = glc->tail;
+		length = glc->tailLength;
+		if (!glc->tailIsWhole)
+		{
+			unsigned char *nl = memchr (data, '\n', length);
+			if (nl)
+			{
+				length -= (nl + 1 - data);
+				data = nl + 1;
+			}
+		}
+		break;
+	case TASTE_TAIL:
+	default:
+		data = glc->tail;
+		length = glc->tailLength;
+		break;
+	}
+
+	/* The peek buffer is not owned by the mio. */
+	return mio_new_memory (data, length, NULL, NULL);
+}
+
 static const struct taster {
 	vString* (* taste) (MIO *);
-        const char     *msg;
+	const char     *msg;
+	enum tasteRange range;
 } eager_tasters[] = {
-        {
+	{
 		.taste  = extractInterpreter,
 		.msg    = "interpreter",
-        },
+		.range  = TASTE_HEAD,
+	},
 	{
 		.taste  = extractZshAutoloadTag,
 		.msg    = "zsh autoload tag",
+		.range  = TASTE_HEAD,
 	},
-        {
+	{
 		.taste  = extractEmacsModeAtFirstLine,
 		.msg    = "emacs mode at the first line",
-        },
-        {
+		.range  = TASTE_HEAD,
+	},
+	{
 		.taste  = extractEmacsModeLanguageAtEOF,
 		.msg    = "emacs mode at the EOF",
-        },
-        {
+		.range  = TASTE_TAIL,
+	},
+	{
 		.taste  = extractVimFileType,
 		.msg    = "vim modeline",
-        },
-		{
+		.range  = TASTE_TAIL_LINES,
+	},
+	{
 		.taste  = extractPHPMark,
 		.msg    = "PHP marker",
-		}
+		.range  = TASTE_HEAD,
+	}
 };
 static langType tasteLanguage (struct getLangCtx *glc, const struct taster *const tasters, int n_tasters,
 			      langType *fallback);
@@ -1293,6 +1421,7 @@ static langType getSpecLanguageCommon (const char *const spec, struct getLangCtx
 		GLC_FOPEN_IF_NECESSARY(glc, fopen_error, memStreamRequired);
 		if (selector) {
 			verbose ("	selector: %p\n", selector);
+			mio_rewind (glc->input);
 			language = pickLanguageBySelection(selector, glc->input, candidates, n_candidates);
 		} else {
 			verbose ("	selector: NONE\n");
@@ -1348,8 +1477,9 @@ tasteLanguage (struct getLangCtx *glc, const struct taster *const tasters, int n
         langType language;
         vString* spec;
 
-        mio_rewind(glc->input);
-	spec = tasters[i].taste(glc->input);
+        MIO *peek = newPeekMio (glc, tasters[i].range);
+	spec = tasters[i].taste(peek);
+        mio_unref (peek);
 
         if (NULL != spec) {
             verbose ("	%s: %s\n", tasters[i].msg, vStringValue (spec));
@@ -1497,6 +1627,7 @@ getFileLanguageForRequestInternal (struct GetLanguageRequest *req)
 		verbose ("	last resort: using \"%s\" parser\n",
 				 getLanguageName (LANG_FALLBACK));
 	}
+	PROBE2 (language__decided, fileName, language);
     return language;
 }
 
@@ -1826,6 +1957,8 @@ static void initializeParserOne (langType lang)
 	if (parser->def->initialize != NULL)
 		parser->def->initialize (lang);
 
+	indexKeywordTable (lang);
+
 	initializeDependencies (parser->def, parser->slaveControlBlock);
 
 	Assert (parser->fileKind != NULL);
@@ -3726,10 +3859,12 @@ static rescanReason createTagsForFile (const langType language,
 	notifyLanguageRegexInputStart (language);
 	notifyInputStart ();
 
+	PROBE2 (parser__enter, language, passCount);
 	if (lang->parser != NULL)
 		lang->parser ();
 	else if (lang->parser2 != NULL)
 		rescan = lang->parser2 (passCount);
+	PROBE2 (parser__leave, language, rescan);
 
 	notifyInputEnd ();
 	notifyLanguageRegexInputEnd (language);
@@ -3824,6 +3959,7 @@ static bool createTagsWithFallback1 (const langType language,
 {
 	bool tagFileResized = false;
 	unsigned long numTags	= numTagsAdded ();
+	size_t numRefs = numReferenceOccurrences ();
 	MIOPos tagfpos;
 	int lastPromise = getLastPromise ();
 	unsigned int passCount = 0;
@@ -3865,6 +4001,7 @@ static bool createTagsWithFallback1 (const langType language,
 			*/
 			setTagFilePosition (&tagfpos);
 			setNumTagsAdded (numTags);
+			truncateReferenceOccurrences (numRefs);
 			writerRescanFailed (numTags);
 			tagFileResized = true;
 			breakPromisesAfter(lastPromise);
@@ -3873,6 +4010,7 @@ static bool createTagsWithFallback1 (const langType language,
 		{
 			tagFilePosition (&tagfpos);
 			numTags = numTagsAdded ();
+			numRefs = numReferenceOccurrences ();
 			lastPromise = getLastPromise ();
 		}
 	}
@@ -3917,7 +4055,9 @@ extern bool runParserInNarrowedInputStream (const langType language,
 				 endLine, endCharOffset,
 				 sourceLineOffset,
 				 promise);
+	PROBE3 (guest__enter, language, startLine, endLine);
 	tagFileResized = createTagsWithFallback1 (language, NULL);
+	PROBE1 (guest__leave, language);
 	popNarrowedInputStream  ();
 	return tagFileResized;
 
@@ -3929,6 +4069,9 @@ static bool createTagsWithFallback (
 {
 	langType exclusive_subparser = LANG_IGNORE;
 	bool tagFileResized = false;
+	unsigned long numTags;
+	size_t numRefs;
+	MIOPos tagfpos;
 
 	Assert (0 <= language  &&  language < (int) LanguageCount);
 
@@ -3939,6 +4082,16 @@ static bool createTagsWithFallback (
 	}
 	*failureInOpenning = false;
 
+	/* The pseudo tags of the parser are kept even if the tags for
+	 * the input are discarded below. */
+	initializeParser (language);
+	addParserPseudoTags (language);
+	tagFilePosition (&tagfpos);
+	numTags = numTagsAdded ();
+	spillReferenceOccurrences ();
+	numRefs = numReferenceOccurrences ();
+	resetInputBudget (fileName);
+
 	tagFileResized = createTagsWithFallback1 (language,
 											  &exclusive_subparser);
 	tagFileResized = forcePromises()? true: tagFileResized;
@@ -3948,6 +4101,16 @@ static bool createTagsWithFallback (
 				  : exclusive_subparser);
 	makeFileTag (fileName);
 	popLanguage ();
+
+	if (isInputBudgetExceeded ())
+	{
+		/* Don't leave the tags for the input partially. */
+		setTagFilePosition (&tagfpos);
+		setNumTagsAdded (numTags);
+		truncateReferenceOccurrences (numRefs);
+		writerRescanFailed (numTags);
+		tagFileResized = true;
+	}
 	closeInputFile ();
 
 	return tagFileResized;
@@ -4061,6 +4224,14 @@ extern bool doesParserRequireMemoryStream (const langType language)
 		return true;
 	}
 
+	/* Multiline regex patterns are matched against the input data
+	 * on memory. */
+	if (regexNeedsMultilineBuffer (LanguageTable [language].lregexControlBlock))
+	{
+		verbose ("%s requires a memory stream for multiline regex patterns\n", lang->name);
+		return true;
+	}
+
 	for (i = 0; i < lang->dependencyCount; i++)
 	{
 		parserDependency *d = lang->dependencies + i;
@@ -4113,10 +4284,60 @@ static bool parseMio (const char *const fileName, langType language, MIO* mio, t
 		return teardownWriter(fileName);
 }
 
+static bool parseMioWithTagCache (const char *const fileName, langType language, MIO* mio, time_t mtime,
+								  void *clientData)
+{
+	tagCacheKey key;
+	MIO *tagFile;
+	MIO *out;
+	unsigned long numTags;
+	unsigned char *data;
+	size_t size;
+	long length;
+
+	if (!makeTagCacheKey (fileName, language, mio, &key))
+		return parseMio (fileName, language, mio, mtime, true, clientData);
+
+	if (replayTagCache (&key))
+	{
+		verbose ("reuse cached tags for %s\n", fileName);
+		return false;
+	}
+
+	/* Capture the output for the file to store it to the cache. */
+	out = mio_new_memory (NULL, 0, eRealloc, eFreeNoNullCheck);
+	tagFile = divertTagFile (out);
+	numTags = numTagsAdded ();
+
+	parseMio (fileName, language, mio, mtime, true, clientData);
+
+	divertTagFile (tagFile);
+
+	/* Tags are not cached for an input whose parsing was aborted. */
+	if (isInputBudgetExceeded ())
+	{
+		mio_unref (out);
+		return false;
+	}
+
+	/* The data after the current position is left by rescanning. */
+	length = mio_tell (out);
+	data = mio_memory_get_data (out, &size);
+	if (length > 0)
+		appendToTagFile (data, length);
+	storeTagCache (&key, data, length > 0? length: 0,
+				   numTagsAdded () - numTags);
+	mio_unref (out);
+
+	/* Only the valid part of the output is written to the tag file. */
+	return false;
+}
+
 extern bool parseFileWithMio (const char *const fileName, MIO *mio,
 							  void *clientData)
 {
 	bool tagFileResized = false;
+	bool generated = false;
 	langType language;
 	struct GetLanguageRequest req = {
 		.type = mio? GLR_REUSE: GLR_OPEN,
@@ -4125,6 +4346,9 @@ extern bool parseFileWithMio (const char *const fileName, MIO *mio,
 	};
 	memset (&req.mtime, 0, sizeof (req.mtime));
 
+	if (!Option.printLanguage && isInputFileTooLarge (fileName, mio))
+		return tagFileResized;
+
 	language = getFileLanguageForRequest (&req);
 	Assert (language != LANG_AUTO);
 
@@ -4134,13 +4358,25 @@ extern bool parseFileWithMio (const char *const fileName, MIO *mio,
 		return tagFileResized;
 	}
 
+	if (language != LANG_IGNORE && Option.generatedFiles != GENERATED_FILES_PARSE)
+		generated = isGeneratedFile (fileName, req.mio);
+
 	if (language == LANG_IGNORE)
 		verbose ("ignoring %s (unknown language/language disabled)\n",
 			 fileName);
+	else if (generated && Option.generatedFiles == GENERATED_FILES_SKIP)
+		verbose ("ignoring %s (generated file)\n", fileName);
 	else
 	{
+		const exCmd locate = Option.locate;
+
 		Assert(isLanguageEnabled (language));
 
+		/* The tags of a generated file are not worth reading the long
+		 * lines of the file back for their patterns. */
+		if (generated)
+			Option.locate = EX_LINENUM;
+
 		if (Option.filter && ! Option.interactive)
 			openTagFile ();
 
@@ -4148,7 +4384,11 @@ extern bool parseFileWithMio (const char *const fileName, MIO *mio,
 		/* TODO: checkUTF8BOM can be used to update the encodings. */
 		openConverter (getLanguageEncoding (language), Option.outputEncoding);
 #endif
-		tagFileResized = parseMio (fileName, language, req.mio, req.mtime, true, clientData);
+		if (isTagCacheEnabled ())
+			tagFileResized = parseMioWithTagCache (fileName, language, req.mio, req.mtime, clientData);
+		else
+			tagFileResized = parseMio (fileName, language, req.mio, req.mtime, true, clientData);
+		flushTagFile ();
 		if (Option.filter && ! Option.interactive)
 			closeTagFile (tagFileResized);
 		addTotals (1, 0L, 0L);
@@ -4156,6 +4396,7 @@ extern bool parseFileWithMio (const char *const fileName, MIO *mio,
 #ifdef HAVE_ICONV
 		closeConverter ();
 #endif
+		Option.locate = locate;
 	}
 
 	if (req.type == GLR_OPEN && req.mio)
@@ -4181,32 +4422,154 @@ extern bool parseRawBuffer(const char *fileName, unsigned char *buffer,
 	return r;
 }
 
+/* Store the line of BUFFER starting at OFFSET to LINE without its line
+ * break, and return the offset of the next line. */
+static size_t getRawBufferLine (const unsigned char *buffer, size_t bufferSize,
+								size_t offset, vString *line)
+{
+	const unsigned char *start = buffer + offset;
+	const unsigned char *nl = memchr (start, '\n', bufferSize - offset);
+	size_t length = nl? (size_t) (nl - start): bufferSize - offset;
+
+	vStringNCopyS (line, (const char *) start, length);
+	if (vStringLength (line) > 0 && vStringLast (line) == '\r')
+		vStringChop (line);
+	return offset + length + (nl? 1: 0);
+}
+
+/* Extend the lines from *STARTLINE to *ENDLINE to the checkpoints
+ * around them, and return the number of lines in BUFFER. */
+static unsigned long extendRegionToCheckpoints (checkpointChecker isCheckpoint,
+												const unsigned char *buffer,
+												size_t bufferSize,
+												unsigned long *startLine,
+												unsigned long *endLine)
+{
+	vString *prev = vStringNew ();
+	vString *line = vStringNew ();
+	bool *checkpoints;
+	unsigned long count = 0, s, e;
+	size_t offset;
+	int state = 0;
+
+	for (offset = 0; offset < bufferSize; count++)
+		offset = getRawBufferLine (buffer, bufferSize, offset, line);
+	if (count == 0)
+		goto out;
+
+	/* checkpoints [N - 1] tells whether line N is a checkpoint. */
+	checkpoints = xCalloc (count, bool);
+	checkpoints [0] = true;
+	offset = getRawBufferLine (buffer, bufferSize, 0, prev);
+	for (unsigned long n = 1; n < count; n++)
+	{
+		offset = getRawBufferLine (buffer, bufferSize, offset, line);
+		checkpoints [n] = isCheckpoint (vStringValue (prev),
+										vStringValue (line), &state);
+		vStringCopy (prev, line);
+	}
+
+	s = (*startLine == 0)? 1: *startLine;
+	e = (*endLine < s)? s: *endLine;
+	if (e > count)
+		e = count;
+	if (s > e)
+		s = e;
+
+	while (!checkpoints [s - 1])
+		s--;
+	while (e < count && !checkpoints [e])
+		e++;
+
+	eFree (checkpoints);
+	*startLine = s;
+	*endLine = e;
+ out:
+	vStringDelete (line);
+	vStringDelete (prev);
+	return count;
+}
+
+extern bool parseRawBufferRegion (const char *fileName, unsigned char *buffer,
+				  size_t bufferSize, const langType language,
+				  unsigned long *startLine, unsigned long *endLine,
+				  void *clientData)
+{
+	parserDefinition *const def = LanguageTable [language].def;
+	unsigned long s = *startLine, e = *endLine;
+	int lastPromise;
+	MIO *mio;
+	bool r = false;
+
+	Assert (0 <= language  &&  language < (int) LanguageCount);
+
+	if (def->isCheckpoint == NULL || buffer == NULL
+		|| extendRegionToCheckpoints (def->isCheckpoint, buffer, bufferSize,
+									  &s, &e) == 0)
+		return false;
+
+	mio = mio_new_memory (buffer, bufferSize, NULL, NULL);
+
+	setupWriter (clientData);
+	setupAnon ();
+	initParserTrashBox ();
+
+	if (openInputFile (fileName, language, mio, (time_t)0))
+	{
+		if (pushNarrowedInputStreamForLines (s, e))
+		{
+			resetInputBudget (fileName);
+			lastPromise = getLastPromise ();
+			verbose ("reparse %s: lines %lu-%lu\n", fileName, s, e);
+			createTagsWithFallback1 (language, NULL);
+			/* Guest parsers cannot run in the narrowed input. */
+			breakPromisesAfter (lastPromise);
+			popNarrowedInputStream ();
+			r = true;
+		}
+		closeInputFile ();
+	}
+
+	finiParserTrashBox ();
+	teardownAnon ();
+	teardownWriter (fileName);
+
+	mio_unref (mio);
+
+	if (r)
+	{
+		*startLine = s;
+		*endLine = e;
+	}
+	return r;
+}
+
 static void matchLanguageMultilineRegexCommon (const langType language,
-											   bool (* func) (struct lregexControlBlock *, const vString* const),
-											   const vString* const allLines)
+											   bool (* func) (struct lregexControlBlock *, const char *, size_t),
+											   const char *allLines, size_t length)
 {
 	subparser *tmp;
 
-	func ((LanguageTable + language)->lregexControlBlock, allLines);
+	func ((LanguageTable + language)->lregexControlBlock, allLines, length);
 	foreachSubparser(tmp, true)
 	{
 		langType t = getSubparserLanguage (tmp);
 		enterSubparser (tmp);
-		matchLanguageMultilineRegexCommon (t, func, allLines);
+		matchLanguageMultilineRegexCommon (t, func, allLines, length);
 		leaveSubparser ();
 	}
 }
 
 extern void matchLanguageMultilineRegex (const langType language,
-										 const vString* const allLines)
+										 const char *allLines, size_t length)
 {
-	matchLanguageMultilineRegexCommon(language, matchMultilineRegex, allLines);
+	matchLanguageMultilineRegexCommon(language, matchMultilineRegex, allLines, length);
 }
 
 extern void matchLanguageMultitableRegex (const langType language,
-										  const vString* const allLines)
+										  const char *allLines, size_t length)
 {
-	matchLanguageMultilineRegexCommon(language, matchMultitableRegex, allLines);
+	matchLanguageMultilineRegexCommon(language, matchMultitableRegex, allLines, length);
 }
 
 extern void processLanguageMultitableExtendingOption (langType language, const char *const parameter)
@@ -4429,6 +4792,16 @@ const tagXpathTableTable *getXpathTableTable (const langType language, unsigned
 	return lang->tagXpathTableTable + nth;
 }
 
+extern unsigned int getXpathTableTableCount (const langType language)
+{
+	parserDefinition* lang;
+
+	Assert (0 <= language  &&  language < (int) LanguageCount);
+	lang = LanguageTable [language].def;
+
+	return lang->tagXpathTableCount;
+}
+
 extern unsigned int getXpathFileSpecCount (const langType language)
 {
 	parserDefinition* lang;
@@ -42,6 +42,16 @@ typedef void (*parserInitialize) (langType language);
 typedef void (*initStatistics) (langType language);
 typedef void (*printStatistics) (langType langType);
 
+/* Return true if the parser can start parsing at LINE, the line just
+   after PREVLINE, with its initial state; e.g. LINE starts a top level
+   definition. Both are given without their line breaks. The checker is
+   called for each line of the input in order from the second one, and
+   can keep the state of the lines scanned so far, like being in a
+   comment, in STATE, which is 0 at first. A parser defining this can
+   reparse a region of an input with parseRawBufferRegion(). */
+typedef bool (*checkpointChecker) (const char *prevLine, const char *line,
+								   int *state);
+
 /* Per language finalizer is called anytime when ctags exits.
    (Exceptions are a kind of options are given when invoked. Here
    options are: --version, --help, --list-*, and so on.)
@@ -116,6 +126,8 @@ struct sParserDefinition {
 	initStatistics initStats;
 	printStatistics printStats;
 
+	checkpointChecker isCheckpoint;
+
 	/* used internally */
 	langType id;		    /* id assigned to language */
 	unsigned int enabled:1;	       /* currently enabled? */
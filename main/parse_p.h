@@ -126,6 +126,22 @@ extern bool parseFileWithMio (const char *const fileName, MIO *mio, void *client
 extern bool parseRawBuffer(const char *fileName, unsigned char *buffer,
 			    size_t bufferSize, const langType language, void *clientData);
 
+/* Reparse the region of BUFFER including the lines from *STARTLINE to
+ * *ENDLINE, the lines changed since the last parse. The region is
+ * extended to the checkpoints of the parser around the lines, and the
+ * extended lines are stored back to STARTLINE and ENDLINE. The tags
+ * made in the region have line numbers in the whole BUFFER; the caller
+ * replaces its tags in the region with them. Guest parsers are not run
+ * for the region.
+ *
+ * Return false if the parser of LANGUAGE has no checkpoint, or the
+ * region cannot be narrowed; parse the whole buffer with
+ * parseRawBuffer() then. */
+extern bool parseRawBufferRegion (const char *fileName, unsigned char *buffer,
+				  size_t bufferSize, const langType language,
+				  unsigned long *startLine, unsigned long *endLine,
+				  void *clientData);
+
 extern bool runParserInNarrowedInputStream (const langType language,
 					       unsigned long startLine, long startCharOffset,
 					       unsigned long endLine, long endCharOffset,
@@ -152,8 +168,8 @@ extern bool hasLanguageScopeActionInRegex (const langType language);
 
 /* Multiline Regex Interface */
 extern bool hasLanguageMultilineRegexPatterns (const langType language);
-extern void matchLanguageMultilineRegex (const langType language, const vString* const allLines);
-extern void matchLanguageMultitableRegex (const langType language, const vString* const allLines);
+extern void matchLanguageMultilineRegex (const langType language, const char *allLines, size_t length);
+extern void matchLanguageMultitableRegex (const langType language, const char *allLines, size_t length);
 
 extern void processLanguageMultitableExtendingOption (langType language, const char *const parameter);
 
@@ -161,6 +177,7 @@ extern unsigned int   getXpathFileSpecCount (const langType language);
 extern xpathFileSpec* getXpathFileSpec (const langType language, unsigned int nth);
 
 const tagXpathTableTable *getXpathTableTable (const langType language, unsigned int nth);
+extern unsigned int getXpathTableTableCount (const langType language);
 
 extern bool makeKindSeparatorsPseudoTags (const langType language,
 					     const ptagDesc *pdesc);
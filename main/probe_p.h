@@ -0,0 +1,59 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Statically defined tracepoints (USDT probes)
+*
+*   Probes of the "ctags" provider are placed at the boundaries of the
+*   stages processing an input file. When ctags is built with sys/sdt.h
+*   (configure --enable-usdt), they can be attached with tools like
+*   bpftrace or perf while ctags is running, e.g.
+*
+*     bpftrace -e 'usdt:./ctags:ctags:parser__leave { ... }'
+*
+*   A probe not attached costs a nop. Without sys/sdt.h, probes are
+*   compiled out.
+*
+*   input__open (const char *fileName, int language)
+*   input__close (const char *fileName, unsigned long lines)
+*   language__decided (const char *fileName, int language)
+*   parser__enter (int language, unsigned int passCount)
+*   parser__leave (int language, int rescanReason)
+*   promise__made (int language, unsigned long startLine, unsigned long endLine)
+*   guest__enter (int language, unsigned long startLine, unsigned long endLine)
+*   guest__leave (int language)
+*   tag__write (const char *name, const char *inputFileName, unsigned long lineNumber)
+*   sort__start (unsigned long numTags)
+*   sort__end (unsigned long numTags)
+*
+*   Languages are passed as langType; use --list-languages to map them
+*   to names if needed.
+*/
+#ifndef CTAGS_MAIN_PROBE_PRIVATE_H
+#define CTAGS_MAIN_PROBE_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#ifdef HAVE_USDT
+# include <sys/sdt.h>
+#endif
+
+/*
+*   MACROS
+*/
+#ifdef HAVE_USDT
+# define PROBE1(NAME,A1)          DTRACE_PROBE1 (ctags, NAME, A1)
+# define PROBE2(NAME,A1,A2)       DTRACE_PROBE2 (ctags, NAME, A1, A2)
+# define PROBE3(NAME,A1,A2,A3)    DTRACE_PROBE3 (ctags, NAME, A1, A2, A3)
+#else
+# define PROBE1(NAME,A1)          do {} while (0)
+# define PROBE2(NAME,A1,A2)       do {} while (0)
+# define PROBE3(NAME,A1,A2,A3)    do {} while (0)
+#endif
+
+#endif	/* CTAGS_MAIN_PROBE_PRIVATE_H */
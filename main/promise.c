@@ -12,6 +12,7 @@
 
 #include "general.h"
 #include "parse_p.h"
+#include "probe_p.h"
 #include "promise.h"
 #include "promise_p.h"
 #include "ptrarray.h"
@@ -104,6 +105,7 @@ int  makePromise   (const char *parser,
 
 	r = promise_count;
 	promise_count++;
+	PROBE3 (promise__made, lang, startLine, endLine);
 	return r;
 }
 
@@ -287,6 +289,18 @@ static void collectModifiers(int promise, ptrArray *modifiers)
 	}
 }
 
+bool doesPromiseHaveModifiers (int promise)
+{
+	while (promise != NO_PROMISE)
+	{
+		struct promise *p = promises + promise;
+		if (p->modifiers && ptrArrayCount (p->modifiers) > 0)
+			return true;
+		promise = p->parent_promise;
+	}
+	return false;
+}
+
 void runModifiers (int promise,
 				   unsigned long startLine, long startCharOffset,
 				   unsigned long endLine, long endCharOffset,
@@ -17,6 +17,7 @@
 bool forcePromises (void);
 void breakPromisesAfter (int promise);
 int getLastPromise (void);
+bool doesPromiseHaveModifiers (int promise);
 void runModifiers (int promise,
 				   unsigned long startLine, long startCharOffset,
 				   unsigned long endLine, long endCharOffset,
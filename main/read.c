@@ -20,12 +20,14 @@
 #define FILE_WRITE
 #include "read.h"
 #include "read_p.h"
+#include "budget_p.h"
 #include "debug.h"
 #include "entry_p.h"
 #include "routines.h"
 #include "routines_p.h"
 #include "options_p.h"
 #include "parse_p.h"
+#include "probe_p.h"
 #include "promise_p.h"
 #include "stats_p.h"
 #include "trace.h"
@@ -76,11 +78,29 @@ typedef struct sInputLineFposMap {
 	unsigned int size;
 } inputLineFposMap;
 
+/* The index of lines of an input on memory, made in one pass over the
+ * data when a position of a line is asked first. It replaces
+ * inputLineFposMap, which records the lines one by one as they are
+ * read. As inputLineFposMap, lookups are limited to the lines read so
+ * far; parsers asking for the line after the current one (e.g. unwindi)
+ * expect the last line read. */
+typedef struct sInputLineIndex {
+	bool enabled;
+	bool built;
+	long *offsets;              /* offsets of the starts of lines */
+	unsigned int *crAdjustments; /* CR-LF line breaks before the lines,
+									or NULL if the input has no CR */
+	unsigned int count;
+	unsigned int linesRead;
+} inputLineIndex;
+
 typedef struct sNestedInputStreamInfo {
 	unsigned long startLine;
 	long startCharOffset;
 	unsigned long endLine;
 	long endCharOffset;
+	bool guest;				/* false for a region reparsed by the parser
+							   of the whole input */
 } nestedInputStreamInfo;
 
 typedef struct sInputFile {
@@ -110,6 +130,11 @@ typedef struct sInputFile {
 	   in sourceTagPathHolder are destroyed. */
 	stringList  * sourceTagPathHolder;
 	inputLineFposMap lineFposMap;
+	inputLineIndex lineIndex;
+	/* Multiline regex patterns are matched against the input at the end
+	   of the file. allLines is a copy of the lines read, made only if the
+	   input data cannot be used as is. */
+	bool matchAllLines;
 	vString *allLines;
 	int thinDepth;
 	time_t mtime;
@@ -127,6 +152,8 @@ static langType langStackBotom(langStack *langStack);
 static void     langStackPush (langStack *langStack, langType type);
 static langType langStackPop  (langStack *langStack);
 static void     langStackClear(langStack *langStack);
+static inputFile *getLineIndexedFile (void);
+static long getLineIndexOffset (inputFile *f, unsigned int line);
 
 
 /*
@@ -164,34 +191,44 @@ extern MIOPos getInputFilePosition (void)
 	return File.filePosition.pos;
 }
 
-static compoundPos* getInputFileCompoundPosForLine (unsigned int line)
+static unsigned int getLineIndex (unsigned int line, unsigned int count)
 {
-	int index;
 	if (line > 0)
 	{
-		if (File.lineFposMap.count > (line - 1))
-			index = line - 1;
-		else if (File.lineFposMap.count != 0)
-			index = File.lineFposMap.count - 1;
-		else
-			index = 0;
+		if (count > (line - 1))
+			return line - 1;
+		else if (count != 0)
+			return count - 1;
 	}
-	else
-		index = 0;
+	return 0;
+}
 
-	return File.lineFposMap.pos + index;
+static compoundPos* getInputFileCompoundPosForLine (unsigned int line)
+{
+	return File.lineFposMap.pos + getLineIndex (line, File.lineFposMap.count);
 }
 
 extern MIOPos getInputFilePositionForLine (unsigned int line)
 {
-	compoundPos *cpos = getInputFileCompoundPosForLine (line);
-	return cpos->pos;
+	MIOPos pos;
+
+	if (File.lineIndex.enabled)
+	{
+		inputFile *f = getLineIndexedFile ();
+
+		mio_memory_get_pos (f->mio, getLineIndexOffset (f, line), &pos);
+		return pos;
+	}
+
+	return getInputFileCompoundPosForLine (line)->pos;
 }
 
 extern long getInputFileOffsetForLine (unsigned int line)
 {
-	compoundPos *cpos = getInputFileCompoundPosForLine (line);
-	return cpos->offset;
+	if (File.lineIndex.enabled)
+		return getLineIndexOffset (getLineIndexedFile (), line);
+
+	return getInputFileCompoundPosForLine (line)->offset;
 }
 
 extern langType getInputLanguage (void)
@@ -342,6 +379,94 @@ static void appendLineFposMap (inputLineFposMap *lineFposMap, compoundPos *pos,
 	lineFposMap->count++;
 }
 
+/* The index can be made only if the input is on memory. Lines are
+ * counted with LF here, but readLine() doesn't break a line at LF after
+ * NUL. Such an input is left to inputLineFposMap. */
+static bool canUseLineIndex (MIO *mio)
+{
+	size_t size;
+	const unsigned char *data = mio_memory_get_data (mio, &size);
+
+	return data && memchr (data, '\0', size) == NULL;
+}
+
+static void buildLineIndex (inputLineIndex *index, MIO *mio, bool bomFound)
+{
+	size_t size, n = 0, allocated = 0;
+	const char *const data = (const char *) mio_memory_get_data (mio, &size);
+	const char *const end = data + size;
+	const char *p = data + (bomFound? 3: 0);
+	bool hasCR = (memchr (data, '\r', size) != NULL);
+	unsigned int crs = 0;
+
+	Assert (!index->built);
+
+	while (p < end)
+	{
+		const char *nl;
+
+		if (n == allocated)
+		{
+			allocated = allocated? allocated * 2: 256;
+			index->offsets = xRealloc (index->offsets, allocated, long);
+			if (hasCR)
+				index->crAdjustments = xRealloc (index->crAdjustments,
+												 allocated, unsigned int);
+		}
+		index->offsets [n] = p - data;
+		if (hasCR)
+			index->crAdjustments [n] = crs;
+		n++;
+
+		nl = memchr (p, '\n', end - p);
+		if (nl == NULL)
+			break;
+		if (nl > p && nl [-1] == '\r')
+			crs++;
+		p = nl + 1;
+	}
+
+	index->count = n;
+	index->built = true;
+}
+
+static void freeLineIndex (inputLineIndex *index)
+{
+	if (index->offsets)
+		eFree (index->offsets);
+	if (index->crAdjustments)
+		eFree (index->crAdjustments);
+	memset (index, 0, sizeof (*index));
+}
+
+static unsigned int getLineIndexCount (inputLineIndex *index)
+{
+	return (index->linesRead < index->count)? index->linesRead: index->count;
+}
+
+static unsigned long getLineNumberForOffsetWithIndex (inputLineIndex *index,
+													  long offset)
+{
+	unsigned int lo = 0, hi = getLineIndexCount (index);
+
+	/* Find the last line starting at OFFSET or before. The offsets of
+	 * the index are adjusted to the data in which CR-LF is turned into
+	 * LF as readLine() does. */
+	while (lo < hi)
+	{
+		unsigned int mid = lo + (hi - lo) / 2;
+		long start = index->offsets [mid]
+			- (index->crAdjustments? index->crAdjustments [mid]: 0);
+
+		if (start <= offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return (lo == 0)? 1: lo;
+}
+
 static int compoundPosForOffset (const void* oft, const void *p)
 {
 	long offset = *(long *)oft;
@@ -358,10 +483,34 @@ static int compoundPosForOffset (const void* oft, const void *p)
 		return 1;
 }
 
+/* Return the input file holding the line index. In a narrowed input
+ * stream, it is the file narrowed. The index is made here if needed. */
+static inputFile *getLineIndexedFile (void)
+{
+	inputFile *f = BackupFile.mio? &BackupFile: &File;
+
+	if (!f->lineIndex.built)
+		buildLineIndex (&f->lineIndex, f->mio, f->bomFound);
+	return f;
+}
+
+static long getLineIndexOffset (inputFile *f, unsigned int line)
+{
+	unsigned int count = getLineIndexCount (&f->lineIndex);
+
+	if (count == 0)
+		return 0;
+	return f->lineIndex.offsets [getLineIndex (line, count)];
+}
+
 extern unsigned long getInputLineNumberForFileOffset(long offset)
 {
 	compoundPos *p;
 
+	if (File.lineIndex.enabled)
+		return getLineNumberForOffsetWithIndex (&getLineIndexedFile ()->lineIndex,
+												offset);
+
 	p = bsearch (&offset, File.lineFposMap.pos, File.lineFposMap.count, sizeof (compoundPos),
 		     compoundPosForOffset);
 	if (p == NULL)
@@ -626,7 +775,11 @@ static MIO *getMioFull (const char *const fileName, const char *const openMode,
 	if (!src)
 		return NULL;
 
-	data = eMalloc (size);
+	/* The terminator is not a part of the stream. It stops the code
+	 * scanning the data as a C string, like regexec() without
+	 * REG_STARTEND, in the buffer. */
+	data = eMalloc (size + 1);
+	data [size] = '\0';
 	if (fread (data, 1, size, src) != size)
 	{
 		eFree (data);
@@ -745,9 +898,12 @@ extern bool openInputFile (const char *const fileName, const langType language,
 		setSourceFileParameters (vStringNewInit (fileName), language);
 		File.source.lineNumberOrigin = 0L;
 		File.source.lineNumber = File.source.lineNumberOrigin;
-		allocLineFposMap (&File.lineFposMap);
+		File.lineIndex.enabled = canUseLineIndex (File.mio);
+		if (!File.lineIndex.enabled)
+			allocLineFposMap (&File.lineFposMap);
 
 		File.thinDepth = 0;
+		PROBE2 (input__open, fileName, language);
 		verbose ("OPENING%s %s as %s language %sfile [%s%s]\n",
 				 (File.bomFound? "(skipping utf-8 bom)": ""),
 				 fileName,
@@ -764,6 +920,33 @@ extern time_t getInputFileMtime (void)
 	return File.mtime;
 }
 
+/* Return the input data if multiline regex patterns can be matched
+ * against it directly: the data must be on memory, and have the same
+ * contents as the lines read with readLine(), which stops at NUL and
+ * turns CR-LF into LF. */
+static const char *getInputDataForAllLines (size_t *length)
+{
+	size_t size;
+	const char *data = (const char *) getInputFileData (&size);
+
+	if (data == NULL)
+		return NULL;
+
+	if (File.bomFound)
+	{
+		data += 3;
+		size -= 3;
+	}
+
+	if (length == NULL
+		&& (memchr (data, '\r', size) || memchr (data, '\0', size)))
+		return NULL;
+
+	if (length)
+		*length = size;
+	return data;
+}
+
 extern void resetInputFile (const langType language)
 {
 	Assert (File.mio);
@@ -776,8 +959,14 @@ extern void resetInputFile (const langType language)
 
 	if (File.line != NULL)
 		vStringClear (File.line);
-	if (hasLanguageMultilineRegexPatterns (language))
-		File.allLines = vStringNew ();
+	File.matchAllLines = hasLanguageMultilineRegexPatterns (language);
+	if (File.matchAllLines && !getInputDataForAllLines (NULL))
+	{
+		if (File.allLines)
+			vStringClear (File.allLines);
+		else
+			File.allLines = vStringNew ();
+	}
 
 	resetLangOnStack (& inputLang, language);
 	File.input.lineNumber = File.input.lineNumberOrigin;
@@ -790,6 +979,8 @@ extern void closeInputFile (void)
 	if (File.mio != NULL)
 	{
 		clearLangOnStack (& inputLang);
+		PROBE2 (input__close, vStringValue (File.input.name),
+				File.input.lineNumber - 1L);
 
 		/*  The line count of the file is 1 too big, since it is one-based
 		 *  and is incremented upon each newline.
@@ -802,6 +993,7 @@ extern void closeInputFile (void)
 		mio_unref (File.mio);
 		File.mio = NULL;
 		freeLineFposMap (&File.lineFposMap);
+		freeLineIndex (&File.lineIndex);
 	}
 }
 
@@ -817,8 +1009,13 @@ static void fileNewline (bool crAdjustment)
 	File.filePosition = StartOfLine;
 
 	if (BackupFile.mio == NULL)
-		appendLineFposMap (&File.lineFposMap, &File.filePosition,
-						   crAdjustment);
+	{
+		if (File.lineIndex.enabled)
+			File.lineIndex.linesRead++;
+		else
+			appendLineFposMap (&File.lineFposMap, &File.filePosition,
+							   crAdjustment);
+	}
 
 	File.input.lineNumber++;
 	File.source.lineNumber++;
@@ -896,10 +1093,15 @@ static vString *iFileGetLine (void)
 	eolType eol;
 	langType lang = getInputLanguage();
 
+	/* Pretend EOF to let the parser finish soon. */
+	if (isInputBudgetExceeded ())
+		return NULL;
+
 	if (File.line == NULL)
 		File.line = vStringNew ();
 
 	eol = readLine (File.line, File.mio);
+	chargeInputBudgetForInput (vStringLength (File.line));
 
 	if (vStringLength (File.line) > 0)
 	{
@@ -913,22 +1115,37 @@ static vString *iFileGetLine (void)
 			parseLineDirective (vStringValue (File.line) + 1);
 		matchLanguageRegex (lang, File.line);
 
-		if (File.allLines)
+		if (File.matchAllLines && File.allLines)
 			vStringCat (File.allLines, File.line);
 
 		return File.line;
 	}
 	else
 	{
-		if (File.allLines)
+		if (File.matchAllLines)
 		{
-			matchLanguageMultilineRegex (lang, File.allLines);
-			matchLanguageMultitableRegex (lang, File.allLines);
+			const char *allLines;
+			size_t length = 0;
+
+			if (File.allLines)
+			{
+				allLines = vStringValue (File.allLines);
+				length = vStringLength (File.allLines);
+			}
+			else
+				allLines = getInputDataForAllLines (&length);
+
+			matchLanguageMultilineRegex (lang, allLines, length);
+			matchLanguageMultitableRegex (lang, allLines, length);
 
 			/* To limit the execution of multiline/multitable parser(s) only
-			   ONCE, clear File.allLines field. */
-			vStringDelete (File.allLines);
-			File.allLines = NULL;
+			   ONCE, clear File.matchAllLines field. */
+			File.matchAllLines = false;
+			if (File.allLines)
+			{
+				vStringDelete (File.allLines);
+				File.allLines = NULL;
+			}
 		}
 		return NULL;
 	}
@@ -1067,6 +1284,26 @@ extern char *readLineFromBypass (
 	return result;
 }
 
+static void narrowInputStream (MIO *subio,
+							   unsigned long startLine, long startCharOffset,
+							   unsigned long endLine, long endCharOffset,
+							   unsigned long sourceLineOffset,
+							   bool guest)
+{
+	BackupFile = File;
+
+	File.mio = subio;
+	File.bomFound = false;
+	File.nestedInputStreamInfo.startLine = startLine;
+	File.nestedInputStreamInfo.startCharOffset = startCharOffset;
+	File.nestedInputStreamInfo.endLine = endLine;
+	File.nestedInputStreamInfo.endCharOffset = endCharOffset;
+	File.nestedInputStreamInfo.guest = guest;
+
+	File.input.lineNumberOrigin = ((startLine == 0)? 0: startLine - 1);
+	File.source.lineNumberOrigin = ((sourceLineOffset == 0)? 0: sourceLineOffset - 1);
+}
+
 extern void   pushNarrowedInputStream (
 				       unsigned long startLine, long startCharOffset,
 				       unsigned long endLine, long endCharOffset,
@@ -1105,35 +1342,68 @@ extern void   pushNarrowedInputStream (
 	invalidatePatternCache();
 
 	size_t size = q - p;
-	subio = mio_new_mio (File.mio, p, size);
-	if (subio == NULL)
-		error (FATAL, "memory for mio may be exhausted");
+	/* Modifiers rewrite the input; give them a copy. Otherwise, the
+	 * narrowed stream refers to the memory of the current stream. */
+	if (doesPromiseHaveModifiers (promise))
+	{
+		subio = mio_new_mio (File.mio, p, size);
+		if (subio == NULL)
+			error (FATAL, "memory for mio may be exhausted");
+
+		runModifiers (promise,
+					  startLine, startCharOffset,
+					  endLine, endCharOffset,
+					  mio_memory_get_data (subio, NULL),
+					  size);
+	}
+	else
+	{
+		subio = mio_new_view (File.mio, p, size);
+		if (subio == NULL)
+			error (FATAL, "memory for mio may be exhausted");
+	}
 
-	runModifiers (promise,
-				  startLine, startCharOffset,
-				  endLine, endCharOffset,
-				  mio_memory_get_data (subio, NULL),
-				  size);
+	narrowInputStream (subio,
+					   startLine, startCharOffset,
+					   endLine, endCharOffset,
+					   sourceLineOffset, true);
+}
 
-	BackupFile = File;
+extern bool pushNarrowedInputStreamForLines (unsigned long startLine,
+											 unsigned long endLine)
+{
+	inputFile *f;
+	size_t size;
+	long p, q;
+	MIO *subio;
 
-	File.mio = subio;
-	File.bomFound = false;
-	File.nestedInputStreamInfo.startLine = startLine;
-	File.nestedInputStreamInfo.startCharOffset = startCharOffset;
-	File.nestedInputStreamInfo.endLine = endLine;
-	File.nestedInputStreamInfo.endCharOffset = endCharOffset;
+	Assert (BackupFile.mio == NULL && File.thinDepth == 0);
 
-	File.input.lineNumberOrigin = ((startLine == 0)? 0: startLine - 1);
-	File.source.lineNumberOrigin = ((sourceLineOffset == 0)? 0: sourceLineOffset - 1);
+	if (!File.lineIndex.enabled)
+		return false;
+
+	f = getLineIndexedFile ();
+	if (startLine == 0 || startLine > endLine
+		|| startLine > f->lineIndex.count)
+		return false;
+
+	mio_memory_get_data (File.mio, &size);
+	p = f->lineIndex.offsets [startLine - 1];
+	q = (endLine < f->lineIndex.count)? f->lineIndex.offsets [endLine]: (long) size;
+
+	invalidatePatternCache();
+
+	subio = mio_new_view (File.mio, p, q - p);
+	if (subio == NULL)
+		error (FATAL, "memory for mio may be exhausted");
+
+	narrowInputStream (subio, startLine, 0, endLine, 0, startLine, false);
+	return true;
 }
 
 extern bool doesParserRunAsGuest (void)
 {
-	return !(File.nestedInputStreamInfo.startLine == 0
-			 && File.nestedInputStreamInfo.startCharOffset == 0
-			 && File.nestedInputStreamInfo.endLine == 0
-			 && File.nestedInputStreamInfo.endCharOffset == 0);
+	return File.nestedInputStreamInfo.guest;
 }
 
 extern unsigned int getNestedInputBoundaryInfo (unsigned long lineNumber)
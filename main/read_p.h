@@ -73,6 +73,12 @@ extern void   pushNarrowedInputStream (
 				       unsigned long endLine, long endCharOffset,
 				       unsigned long sourceLineOffset,
 				       int promise);
+/* Narrow the input to the lines from STARTLINE to ENDLINE of the input
+ * file, which is not narrowed yet. Unlike pushNarrowedInputStream(),
+ * the lines need not be read yet. Return false if the input is not on
+ * memory, or the lines are out of the input. */
+extern bool   pushNarrowedInputStreamForLines (unsigned long startLine,
+											   unsigned long endLine);
 extern void   popNarrowedInputStream  (void);
 
 #define THIN_STREAM_SPEC 0, 0, 0, 0, 0
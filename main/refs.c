@@ -0,0 +1,403 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Compact output of reference tags (--refs-output)
+*
+*   With --refs-output=FILE, reference tags are not written to the tag
+*   file. They are collected, grouped by name, input file, language and
+*   kind, and written to FILE at the end. readtags lists them with its
+*   --list-references action. All integers are little endian.
+*
+*   Between input files, the collected references are sorted and spilled
+*   to a temporary file as a sorted run once they use more than
+*   REFS_MEMORY_LIMIT bytes, and the runs are merged with a heap at the
+*   end. The memory is bounded by the limit plus the references of one
+*   input file, and the strings of the references (names, file names,
+*   languages, kinds and roles), which are kept interned through the run.
+*
+*     header:   "CTAGSREF", version (4 bytes), number of strings (4 bytes),
+*               number of names (4 bytes), size of the string table
+*               (8 bytes)
+*     strings:  NUL terminated strings referred by their indexes
+*     offsets:  for each string, its offset in the file (8 bytes)
+*     names:    for each name in byte order, the string index of the
+*               name (4 bytes) and the offset of its groups in the file
+*               (8 bytes)
+*     groups:   for each name, the number of groups, then for each group,
+*               the string indexes of the input file, the language and
+*               the kind, the number of occurrences, and for each
+*               occurrence in ascending order of lines, the line number
+*               as the delta from the previous one and the string index
+*               of the roles; all encoded as LEB128
+*
+*   With the offsets and the sorted names, a reader looks up a name with
+*   a binary search, reading only the strings it compares.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debug.h"
+#include "entry_p.h"
+#include "field_p.h"
+#include "htable.h"
+#include "options_p.h"
+#include "parse.h"
+#include "ptrarray.h"
+#include "refs_p.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "sortedruns_p.h"
+
+/*
+*   MACROS
+*/
+#define REFS_OUTPUT_MAGIC     "CTAGSREF"
+#define REFS_OUTPUT_VERSION   2
+#define HEADER_SIZE           28
+#define NAME_ENTRY_SIZE       12
+#define STRING_OFFSET_SIZE    8
+
+#ifndef REFS_MEMORY_LIMIT
+#define REFS_MEMORY_LIMIT     (64 * 1024 * 1024)
+#endif
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sOccurrence {
+	unsigned int name;
+	unsigned int file;
+	unsigned int language;
+	unsigned int kind;
+	unsigned int roles;
+	unsigned long line;
+} occurrence;
+
+typedef struct sOccurrenceArray {
+	occurrence *occurrences;
+	size_t count;
+	size_t size;
+} occurrenceArray;
+
+typedef struct sNameEntry {
+	unsigned int name;
+	size_t groups;
+	uint64_t size;				/* of the groups in the file */
+} nameEntry;
+
+/*
+*   DATA DEFINITIONS
+*/
+static occurrenceArray Occurrences;
+static size_t SpilledOccurrences;
+
+static sortedRuns *Runs;
+
+/* Strings interned for the occurrences, and their indexes + 1 */
+static ptrArray *Strings;
+static hashTable *StringIndexes;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+extern bool isReferenceOutputEnabled (void)
+{
+	return Option.refsOutput != NULL && !Option.interactive;
+}
+
+static unsigned int internString (const char *const s)
+{
+	void *index = hashTableGetItem (StringIndexes, s);
+
+	if (index)
+		return HT_PTR_TO_UINT (index) - 1;
+
+	char *copy = eStrdup (s);
+	unsigned int i = ptrArrayAdd (Strings, copy);
+	hashTablePutItem (StringIndexes, copy, HT_UINT_TO_PTR (i + 1));
+	return i;
+}
+
+static const char *stringOf (unsigned int index)
+{
+	return ptrArrayItem (Strings, index);
+}
+
+static occurrence *appendOccurrence (occurrenceArray *const a)
+{
+	if (a->count == a->size)
+	{
+		a->size = a->size? a->size * 2: 1024;
+		a->occurrences = xRealloc (a->occurrences, a->size, occurrence);
+	}
+	return a->occurrences + a->count++;
+}
+
+extern void addReferenceOccurrence (const tagEntryInfo *const tag)
+{
+	occurrence *o;
+
+	Assert (tag->extensionFields.roleBits);
+
+	if (Strings == NULL)
+	{
+		Strings = ptrArrayNew (eFree);
+		StringIndexes = hashTableNew (1024, hashCstrhash, hashCstreq, NULL, NULL);
+	}
+
+	o = appendOccurrence (&Occurrences);
+	o->name = internString (tag->name);
+	o->file = internString (tag->inputFileName);
+	o->language = internString (getLanguageName (tag->langType));
+	o->kind = internString (getTagKind (tag)->name);
+	o->roles = internString (renderField (FIELD_ROLES, tag, NO_PARSER_FIELD));
+	o->line = tag->lineNumber;
+}
+
+extern size_t numReferenceOccurrences (void)
+{
+	return SpilledOccurrences + Occurrences.count;
+}
+
+extern void truncateReferenceOccurrences (size_t count)
+{
+	Assert (SpilledOccurrences <= count);
+	Assert (count <= SpilledOccurrences + Occurrences.count);
+	Occurrences.count = count - SpilledOccurrences;
+}
+
+static bool isSameGroup (const occurrence *a, const occurrence *b)
+{
+	return a->name == b->name && a->file == b->file
+		&& a->language == b->language && a->kind == b->kind;
+}
+
+static int compareStrings (unsigned int a, unsigned int b)
+{
+	return (a == b)? 0: strcmp (stringOf (a), stringOf (b));
+}
+
+static int compareOccurrences (const void *a, const void *b)
+{
+	const occurrence *oa = a;
+	const occurrence *ob = b;
+	int r;
+
+	if ((r = compareStrings (oa->name, ob->name)) != 0
+		|| (r = compareStrings (oa->file, ob->file)) != 0
+		|| (r = compareStrings (oa->language, ob->language)) != 0
+		|| (r = compareStrings (oa->kind, ob->kind)) != 0)
+		return r;
+	if (oa->line != ob->line)
+		return (oa->line < ob->line)? -1: 1;
+	return compareStrings (oa->roles, ob->roles);
+}
+
+static void sortOccurrences (void)
+{
+	qsort (Occurrences.occurrences, Occurrences.count,
+		   sizeof (Occurrences.occurrences [0]), compareOccurrences);
+}
+
+static sortedRuns *getRuns (void)
+{
+	if (Runs == NULL)
+		Runs = sortedRunsNew (sizeof (occurrence), compareOccurrences);
+	return Runs;
+}
+
+static void spillSortedRun (void)
+{
+	sortOccurrences ();
+	sortedRunsSpill (getRuns (), Occurrences.occurrences, Occurrences.count);
+
+	SpilledOccurrences += Occurrences.count;
+	Occurrences.count = 0;
+}
+
+extern void spillReferenceOccurrences (void)
+{
+	if (Occurrences.count * sizeof (Occurrences.occurrences [0]) >= REFS_MEMORY_LIMIT)
+		spillSortedRun ();
+}
+
+/* Write a group of occurrences to FP, and return the number of bytes.
+ * If FP is NULL, nothing is written. */
+static uint64_t writeGroup (FILE *fp, const occurrenceArray *const g)
+{
+	const occurrence *o = g->occurrences;
+	uint64_t size = 0;
+	unsigned long last = 0;
+
+	size += writeLEB128 (fp, o [0].file);
+	size += writeLEB128 (fp, o [0].language);
+	size += writeLEB128 (fp, o [0].kind);
+	size += writeLEB128 (fp, g->count);
+	for (size_t k = 0; k < g->count; k++)
+	{
+		size += writeLEB128 (fp, o [k].line - last);
+		size += writeLEB128 (fp, o [k].roles);
+		last = o [k].line;
+	}
+	return size;
+}
+
+/* Walk the merged occurrences name by name. If FP is NULL, the groups
+ * of each name are counted and measured, and stored to NAMES. Otherwise,
+ * they are written to FP with the counts stored in NAMES. A group is
+ * assembled in memory; it has the references to a name in an input file. */
+static void walkNames (FILE *fp, nameEntry **names, size_t *nameCount)
+{
+	occurrenceArray group = { NULL, 0, 0 };
+	occurrence o;
+	size_t n = 0;
+	bool more;
+
+	sortedRunsMerge (Runs, Occurrences.occurrences, Occurrences.count);
+	more = sortedRunsNext (Runs, &o);
+	while (more)
+	{
+		const unsigned int name = o.name;
+		size_t groups = 0;
+		uint64_t size = 0;
+
+		if (fp)
+			writeLEB128 (fp, (*names) [n].groups);
+		do
+		{
+			group.count = 0;
+			do
+			{
+				*appendOccurrence (&group) = o;
+				more = sortedRunsNext (Runs, &o);
+			} while (more && isSameGroup (group.occurrences, &o));
+			size += writeGroup (fp, &group);
+			groups++;
+		} while (more && o.name == name);
+
+		if (fp == NULL)
+		{
+			if ((n & (n - 1)) == 0)
+				*names = xRealloc (*names, n? n * 2: 1, nameEntry);
+			(*names) [n].name = name;
+			(*names) [n].groups = groups;
+			(*names) [n].size = size + sizeOfLEB128 (groups);
+		}
+		n++;
+	}
+
+	if (group.occurrences)
+		eFree (group.occurrences);
+	if (fp == NULL)
+		*nameCount = n;
+}
+
+static void writeReferences (FILE *fp)
+{
+	nameEntry *names = NULL;
+	size_t nameCount = 0;
+	unsigned int nStrings;
+	uint64_t stringTableSize = 0;
+	uint64_t offset;
+	size_t i;
+
+	walkNames (NULL, &names, &nameCount);
+
+	nStrings = nameCount? ptrArrayCount (Strings): 0;
+	for (i = 0; i < nStrings; i++)
+		stringTableSize += strlen (stringOf (i)) + 1;
+
+	fwrite (REFS_OUTPUT_MAGIC, 1, strlen (REFS_OUTPUT_MAGIC), fp);
+	writeUintLE (fp, REFS_OUTPUT_VERSION, 4);
+	writeUintLE (fp, nStrings, 4);
+	writeUintLE (fp, nameCount, 4);
+	writeUintLE (fp, stringTableSize, 8);
+
+	for (i = 0; i < nStrings; i++)
+		fwrite (stringOf (i), 1, strlen (stringOf (i)) + 1, fp);
+
+	offset = HEADER_SIZE;
+	for (i = 0; i < nStrings; i++)
+	{
+		writeUintLE (fp, offset, STRING_OFFSET_SIZE);
+		offset += strlen (stringOf (i)) + 1;
+	}
+
+	offset = HEADER_SIZE + stringTableSize
+		+ (uint64_t) nStrings * STRING_OFFSET_SIZE
+		+ (uint64_t) nameCount * NAME_ENTRY_SIZE;
+	for (i = 0; i < nameCount; i++)
+	{
+		writeUintLE (fp, names [i].name, 4);
+		writeUintLE (fp, offset, 8);
+		offset += names [i].size;
+	}
+
+	walkNames (fp, &names, &nameCount);
+
+	if (names)
+		eFree (names);
+}
+
+static void freeReferences (void)
+{
+	if (Occurrences.occurrences)
+		eFree (Occurrences.occurrences);
+	memset (&Occurrences, 0, sizeof (Occurrences));
+	SpilledOccurrences = 0;
+
+	if (Runs)
+		sortedRunsDelete (Runs);
+	Runs = NULL;
+
+	if (Strings)
+	{
+		hashTableDelete (StringIndexes);
+		ptrArrayDelete (Strings);
+		StringIndexes = NULL;
+		Strings = NULL;
+	}
+}
+
+extern void writeReferenceOutput (void)
+{
+	const char *const fileName = Option.refsOutput;
+	FILE *fp;
+	bool r;
+
+	if (!isReferenceOutputEnabled ())
+		return;
+
+	sortOccurrences ();
+	getRuns ();
+
+	fp = fopen (fileName, "wb");
+	if (fp == NULL)
+		error (WARNING | PERROR, "cannot open reference output file %s", fileName);
+	else
+	{
+		writeReferences (fp);
+		r = !ferror (fp);
+		if (fclose (fp) == EOF)
+			r = false;
+		if (!r)
+		{
+			error (WARNING | PERROR, "failed to write reference output file %s", fileName);
+			remove (fileName);
+		}
+	}
+
+	freeReferences ();
+}
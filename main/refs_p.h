@@ -0,0 +1,42 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Compact output of reference tags (--refs-output)
+*/
+#ifndef CTAGS_MAIN_REFS_PRIVATE_H
+#define CTAGS_MAIN_REFS_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "entry.h"
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern bool isReferenceOutputEnabled (void);
+
+/* Record TAG, a reference tag, to the reference output instead of
+ * writing it to the tag file. */
+extern void addReferenceOccurrence (const tagEntryInfo *const tag);
+
+/* The number of the recorded references, and discarding the references
+ * recorded after the number was taken, as the tag file is rolled back
+ * with setTagFilePosition (). */
+extern size_t numReferenceOccurrences (void);
+extern void truncateReferenceOccurrences (size_t count);
+
+/* Spill the recorded references to a temporary file if they use much
+ * memory. Call this only between input files; the spilled references
+ * cannot be discarded with truncateReferenceOccurrences (). */
+extern void spillReferenceOccurrences (void);
+
+/* Write the recorded references to the file given with --refs-output. */
+extern void writeReferenceOutput (void);
+
+#endif	/* CTAGS_MAIN_REFS_PRIVATE_H */
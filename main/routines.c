@@ -478,6 +478,13 @@ extern fileStatus *eStat (const char *const fileName)
 				file.isSetgid = (bool) ((status.st_mode & S_ISGID) != 0);
 				file.size = status.st_size;
 				file.mtime = status.st_mtime;
+#if defined(HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC)
+				file.mtimeNsec = status.st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC_TV_NSEC)
+				file.mtimeNsec = status.st_mtimespec.tv_nsec;
+#else
+				file.mtimeNsec = 0;
+#endif
 			}
 		}
 	}
@@ -958,3 +965,106 @@ extern MIO *tempFile (const char *const mode, char **const pName)
 	*pName = name;
 	return mio;
 }
+
+/* Open a temporary file in the directory of FILENAME for writing its new
+ * contents. The name of the temporary file is stored to PNAME. Call
+ * replaceFile () after closing it. NULL is returned if it cannot be
+ * opened. */
+extern FILE *openFileForReplacing (const char *const fileName, char **const pName)
+{
+	FILE *fp;
+	char *name;
+#if defined(HAVE_MKSTEMP)
+	const char *const suffix = ".XXXXXX";
+	int fd;
+
+	name = xMalloc (strlen (fileName) + strlen (suffix) + 1, char);
+	sprintf (name, "%s%s", fileName, suffix);
+	fd = mkstemp (name);
+# ifndef WIN32
+	if (fd != -1)
+	{
+		/* Give the permissions fopen () would give, instead of the
+		 * owner only ones of mkstemp (). */
+		mode_t mask = umask (0);
+		umask (mask);
+		chmod (name, 0666 & ~mask);
+	}
+# endif
+	fp = (fd == -1)? NULL: fdopen (fd, "wb");
+	if (fp == NULL && fd != -1)
+	{
+		close (fd);
+		remove (name);
+	}
+#else
+	const char *const suffix = ".tmp";
+
+	name = xMalloc (strlen (fileName) + strlen (suffix) + 1, char);
+	sprintf (name, "%s%s", fileName, suffix);
+	fp = fopen (name, "wb");
+#endif
+	if (fp == NULL)
+	{
+		eFree (name);
+		return NULL;
+	}
+	Assert (*pName == NULL);
+	*pName = name;
+	return fp;
+}
+
+/* Rename the temporary file TEMPNAME opened with openFileForReplacing ()
+ * to FILENAME, replacing the file. The readers of FILENAME see either
+ * the old or the new contents. TEMPNAME is removed on failure. */
+extern bool replaceFile (const char *const tempName, const char *const fileName)
+{
+	int r = rename (tempName, fileName);
+
+#ifdef WIN32
+	/* rename () of Windows does not replace an existing file. */
+	if (r != 0 && remove (fileName) == 0)
+		r = rename (tempName, fileName);
+#endif
+	if (r != 0)
+	{
+		int e = errno;
+		remove (tempName);
+		errno = e;
+	}
+	return r == 0;
+}
+
+extern size_t sizeOfLEB128 (uint64_t n)
+{
+	size_t size = 1;
+
+	while (n >= 0x80)
+	{
+		n >>= 7;
+		size++;
+	}
+	return size;
+}
+
+extern size_t writeLEB128 (FILE *fp, uint64_t n)
+{
+	size_t size = sizeOfLEB128 (n);
+
+	if (fp == NULL)
+		return size;
+
+	while (n >= 0x80)
+	{
+		fputc ((int) ((n & 0x7f) | 0x80), fp);
+		n >>= 7;
+	}
+	fputc ((int) n, fp);
+	return size;
+}
+
+extern void writeUintLE (FILE *fp, uint64_t n, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+		fputc ((int) ((n >> (8 * i)) & 0xff), fp);
+}
@@ -13,6 +13,10 @@
 *   INCLUDE FILES
 */
 #include "general.h"  /* must always come first */
+
+#include <stdint.h>
+#include <stdio.h>
+
 #include "mio.h"
 #include "portable-dirent_p.h"
 
@@ -71,6 +75,9 @@ typedef struct {
 
 		/* The last modified time */
 	time_t mtime;
+
+		/* Nanoseconds of the last modified time, or 0 if unknown */
+	long mtimeNsec;
 } fileStatus;
 
 /*
@@ -95,7 +102,16 @@ extern char* absoluteFilename (const char *file);
 extern char* absoluteDirname (char *file);
 extern char* relativeFilename (const char *file, const char *dir);
 extern MIO *tempFile (const char *const mode, char **const pName);
+extern FILE *openFileForReplacing (const char *const fileName, char **const pName);
+extern bool replaceFile (const char *const tempName, const char *const fileName);
 
 extern char* baseFilenameSansExtensionNew (const char *const fileName, const char *const templateExt);
 
+/* Writing integers to binary files. writeLEB128 () returns the number
+ * of bytes, and only counts it if FP is NULL. writeUintLE () writes
+ * the lowest BYTES bytes of N in little endian. */
+extern size_t sizeOfLEB128 (uint64_t n);
+extern size_t writeLEB128 (FILE *fp, uint64_t n);
+extern void writeUintLE (FILE *fp, uint64_t n, int bytes);
+
 #endif  /* CTAGS_MAIN_ROUTINES_PRIVATE_H */
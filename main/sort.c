@@ -15,6 +15,8 @@
 #if defined (HAVE_IO_H)
 # include <io.h>
 #endif
+#include <ctype.h>
+#include <stdint.h>
 #include <stdlib.h>  /* to declare malloc () */
 #if defined (HAVE_UNISTD_H)
 # include <unistd.h>
@@ -33,18 +35,6 @@
 *   FUNCTION DEFINITIONS
 */
 
-extern void catFile (MIO *mio)
-{
-	if (mio != NULL)
-	{
-		int c;
-		mio_seek (mio, 0, SEEK_SET);
-		while ((c = mio_getc (mio)) != EOF)
-			putchar (c);
-		fflush (stdout);
-	}
-}
-
 #ifdef EXTERNAL_SORT
 
 #ifdef NON_CONST_PUTENV_PROTOTYPE
@@ -174,24 +164,77 @@ extern void failedSort (MIO *const mio, const char* msg)
 		error (FATAL, "%s: %s", msg, cannotSort);
 }
 
+/*  Each line is sorted with a key made from its first bytes, which is
+ *  the start of the tag name. Most lines are ordered by comparing the
+ *  keys in a contiguous table; the lines themselves are compared only
+ *  when the keys are the same.
+ */
+typedef struct sSortEntry {
+	uint64_t key;
+	union {
+		size_t offset;  /* while the lines are being read */
+		char *line;
+	} u;
+} sortEntry;
+
+/*  The key keeps the order of strcmp (): unsigned bytes, and the bytes
+ *  after the terminator are filled with zero.
+ */
+static uint64_t makeKey (const char *const line)
+{
+	const unsigned char *p = (const unsigned char *) line;
+	uint64_t key = 0;
+	int i;
+
+	for (i = 0; i < 8 && p [i] != '\0'; i++)
+		key = (key << 8) | p [i];
+	for (; i < 8; i++)
+		key <<= 8;
+	return key;
+}
+
+/*  The key keeps the order of struppercmp (): toupper () of each char
+ *  is taken in 16 bits with an offset making it positive. Bytes after
+ *  the terminator are filled with the value for the terminator.
+ */
+static uint64_t makeFoldedKey (const char *const line)
+{
+	uint64_t key = 0;
+	bool terminated = false;
+
+	for (int i = 0; i < 4; i++)
+	{
+		int c = terminated? 0: line [i];
+
+		if (c == '\0')
+			terminated = true;
+		key = (key << 16) | (uint16_t) (toupper (c) + 0x8000);
+	}
+	return key;
+}
+
 static int compareTagsFolded(const void *const one, const void *const two)
 {
-	const char *const line1 = *(const char* const*) one;
-	const char *const line2 = *(const char* const*) two;
+	const sortEntry *const e1 = one;
+	const sortEntry *const e2 = two;
 
-	return struppercmp (line1, line2);
+	if (e1->key != e2->key)
+		return (e1->key < e2->key)? -1: 1;
+	return struppercmp (e1->u.line, e2->u.line);
 }
 
 static int compareTags (const void *const one, const void *const two)
 {
-	const char *const line1 = *(const char* const*) one;
-	const char *const line2 = *(const char* const*) two;
+	const sortEntry *const e1 = one;
+	const sortEntry *const e2 = two;
 
-	return strcmp (line1, line2);
+	if (e1->key != e2->key)
+		return (e1->key < e2->key)? -1: 1;
+	return strcmp (e1->u.line, e2->u.line);
 }
 
 static void writeSortedTags (
-		char **const table, const size_t numTags, const bool toStdout, bool newlineReplaced)
+		sortEntry *const table, const size_t numTags, const bool toStdout, bool newlineReplaced)
 {
 	MIO *mio;
 	size_t i;
@@ -211,9 +254,9 @@ static void writeSortedTags (
 		/*  Here we filter out identical tag *lines* (including search
 		 *  pattern) if this is not an xref file.
 		 */
-		if (i == 0  ||  Option.xref  ||  strcmp (table [i], table [i-1]) != 0)
+		if (i == 0  ||  Option.xref  ||  strcmp (table [i].u.line, table [i-1].u.line) != 0)
 		{
-			if (mio_puts (mio, table [i]) == EOF)
+			if (mio_puts (mio, table [i].u.line) == EOF)
 				failedSort (mio, NULL);
 			else if (newlineReplaced)
 				mio_putc (mio, '\n');
@@ -230,16 +273,28 @@ extern void internalSortTags (const bool toStdout, MIO* mio, size_t numTags)
 	const char *line;
 	size_t i;
 	int (*cmpFunc)(const void *, const void *);
+	uint64_t (*keyFunc)(const char *const);
 	bool newlineReplaced = false;
 
-	/*  Allocate a table of line pointers to be sorted.
+	/*  Allocate a table of line entries to be sorted. The lines are
+	 *  stored one after another in a single buffer.
 	 */
-	const size_t tableSize = numTags * sizeof (char *);
-	char **table = (char **) malloc (tableSize);  /* line pointers */
-	DebugStatement ( size_t mallocSize = tableSize; )  /* cumulative total */
+	const size_t tableSize = numTags * sizeof (sortEntry);
+	sortEntry *table = (sortEntry *) malloc (tableSize);
+	char *buffer = NULL;
+	size_t bufferSize = 0;
+	size_t bufferUsed = 0;
 
-
-	cmpFunc = Option.sorted == SO_FOLDSORTED ? compareTagsFolded : compareTags;
+	if (Option.sorted == SO_FOLDSORTED)
+	{
+		cmpFunc = compareTagsFolded;
+		keyFunc = makeFoldedKey;
+	}
+	else
+	{
+		cmpFunc = compareTags;
+		keyFunc = makeKey;
+	}
 	if (table == NULL)
 		failedSort (mio, "out of memory");
 
@@ -257,32 +312,44 @@ extern void internalSortTags (const bool toStdout, MIO* mio, size_t numTags)
 		else
 		{
 			const size_t stringSize = strlen (line) + 1;
+			char *s;
 
-			table [i] = (char *) malloc (stringSize);
-			if (table [i] == NULL)
-				failedSort (mio, "out of memory");
-			DebugStatement ( mallocSize += stringSize; )
-			strcpy (table [i], line);
-			if (table[i][stringSize - 2] == '\n')
+			if (bufferUsed + stringSize > bufferSize)
+			{
+				bufferSize = bufferSize? bufferSize * 2: 64 * 1024;
+				while (bufferUsed + stringSize > bufferSize)
+					bufferSize *= 2;
+				buffer = (char *) realloc (buffer, bufferSize);
+				if (buffer == NULL)
+					failedSort (mio, "out of memory");
+			}
+			s = buffer + bufferUsed;
+			memcpy (s, line, stringSize);
+			if (stringSize >= 2 && s [stringSize - 2] == '\n')
 			{
-				table[i][stringSize - 2] = '\0';
+				s [stringSize - 2] = '\0';
 				newlineReplaced = true;
 			}
+			table [i].key = keyFunc (s);
+			table [i].u.offset = bufferUsed;
+			bufferUsed += stringSize;
 			++i;
 		}
 	}
 	numTags = i;
 	vStringDelete (vLine);
 
+	for (i = 0 ; i < numTags ; ++i)
+		table [i].u.line = buffer + table [i].u.offset;
+
 	/*  Sort the lines.
 	 */
 	qsort (table, numTags, sizeof (*table), cmpFunc);
 
 	writeSortedTags (table, numTags, toStdout, newlineReplaced);
 
-	PrintStatus (("sort memory: %ld bytes\n", (long) mallocSize));
-	for (i = 0 ; i < numTags ; ++i)
-		free (table [i]);
+	PrintStatus (("sort memory: %ld bytes\n", (long) (tableSize + bufferSize)));
+	free (buffer);
 	free (table);
 }
 
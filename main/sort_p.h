@@ -21,8 +21,6 @@
 /*
 *   FUNCTION PROTOTYPES
 */
-extern void catFile (MIO *mio);
-
 #ifdef EXTERNAL_SORT
 extern void externalSortTags (const bool toStdout, MIO *tagFile);
 #else
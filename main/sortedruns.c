@@ -0,0 +1,246 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Sorting fixed size records in bounded memory with sorted runs
+*
+*   A writer collecting too many records for its memory sorts them with
+*   the comparison function given to sortedRunsNew (), and spills them
+*   to a temporary file as a sorted run. At the end, the runs and the
+*   records left in memory are merged with a heap. Records are written
+*   in the native byte order; the runs are read back only by the same
+*   process.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "debug.h"
+#include "mio.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "sortedruns_p.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sSortedRun {
+	MIO *mio;
+	char *name;
+} sortedRun;
+
+/* A cursor reads the records of a sorted run, or the ones in memory if
+ * MIO is NULL, for merging. */
+typedef struct sRunCursor {
+	MIO *mio;
+	size_t next;
+} runCursor;
+
+struct sSortedRuns {
+	size_t recordSize;
+	sortedRunsCompareFunc compare;
+
+	sortedRun *runs;
+	unsigned int count;
+
+	/* for merging */
+	const unsigned char *records;
+	size_t recordCount;
+	runCursor *cursors;
+	unsigned char *current;		/* the record at each cursor */
+	unsigned int *heap;			/* indexes of the cursors having one */
+	unsigned int heapCount;
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+extern sortedRuns *sortedRunsNew (size_t recordSize, sortedRunsCompareFunc compare)
+{
+	sortedRuns *runs = xCalloc (1, sortedRuns);
+
+	runs->recordSize = recordSize;
+	runs->compare = compare;
+	return runs;
+}
+
+static void freeMerge (sortedRuns *runs)
+{
+	if (runs->cursors)
+	{
+		eFree (runs->cursors);
+		eFree (runs->current);
+		eFree (runs->heap);
+	}
+	runs->cursors = NULL;
+	runs->current = NULL;
+	runs->heap = NULL;
+}
+
+extern void sortedRunsDelete (sortedRuns *runs)
+{
+	for (unsigned int i = 0; i < runs->count; i++)
+	{
+		mio_unref (runs->runs [i].mio);
+		remove (runs->runs [i].name);
+		eFree (runs->runs [i].name);
+	}
+	if (runs->runs)
+		eFree (runs->runs);
+	freeMerge (runs);
+	eFree (runs);
+}
+
+extern unsigned int sortedRunsCount (const sortedRuns *runs)
+{
+	return runs->count;
+}
+
+extern void sortedRunsSpill (sortedRuns *runs, const void *records, size_t count)
+{
+	sortedRun *run;
+
+	Assert (runs->cursors == NULL);
+
+	runs->runs = xRealloc (runs->runs, runs->count + 1, sortedRun);
+	run = runs->runs + runs->count++;
+	run->name = NULL;
+	run->mio = tempFile ("w+b", &run->name);
+
+	if (mio_write (run->mio, records, runs->recordSize, count) != count)
+		error (FATAL | PERROR, "cannot write a sorted run to temporary file %s",
+			   run->name);
+}
+
+static unsigned char *currentOf (sortedRuns *runs, unsigned int cursor)
+{
+	return runs->current + runs->recordSize * cursor;
+}
+
+static bool readCursor (sortedRuns *runs, unsigned int cursor)
+{
+	runCursor *c = runs->cursors + cursor;
+	unsigned char *current = currentOf (runs, cursor);
+
+	if (c->mio == NULL)
+	{
+		if (c->next == runs->recordCount)
+			return false;
+		memcpy (current, runs->records + runs->recordSize * c->next++,
+				runs->recordSize);
+		return true;
+	}
+
+	if (mio_read (c->mio, current, runs->recordSize, 1) == 1)
+		return true;
+	if (mio_error (c->mio))
+		error (FATAL | PERROR, "cannot read a sorted run from temporary file");
+	return false;
+}
+
+static int compareCursors (sortedRuns *runs, unsigned int a, unsigned int b)
+{
+	int r = runs->compare (currentOf (runs, a), currentOf (runs, b));
+
+	/* Equal records are taken in the order of the runs. */
+	if (r == 0 && a != b)
+		r = (a < b)? -1: 1;
+	return r;
+}
+
+static void swapHeap (sortedRuns *runs, unsigned int i, unsigned int j)
+{
+	unsigned int tmp = runs->heap [i];
+
+	runs->heap [i] = runs->heap [j];
+	runs->heap [j] = tmp;
+}
+
+static void siftUp (sortedRuns *runs, unsigned int i)
+{
+	while (i > 0)
+	{
+		unsigned int parent = (i - 1) / 2;
+
+		if (compareCursors (runs, runs->heap [i], runs->heap [parent]) >= 0)
+			break;
+		swapHeap (runs, i, parent);
+		i = parent;
+	}
+}
+
+static void siftDown (sortedRuns *runs, unsigned int i)
+{
+	while (true)
+	{
+		unsigned int top = i;
+		unsigned int l = 2 * i + 1;
+		unsigned int r = l + 1;
+
+		if (l < runs->heapCount
+			&& compareCursors (runs, runs->heap [l], runs->heap [top]) < 0)
+			top = l;
+		if (r < runs->heapCount
+			&& compareCursors (runs, runs->heap [r], runs->heap [top]) < 0)
+			top = r;
+		if (top == i)
+			break;
+		swapHeap (runs, i, top);
+		i = top;
+	}
+}
+
+extern void sortedRunsMerge (sortedRuns *runs, const void *records, size_t count)
+{
+	const unsigned int cursorCount = runs->count + 1;
+
+	if (runs->cursors == NULL)
+	{
+		runs->cursors = xCalloc (cursorCount, runCursor);
+		runs->current = xMalloc (runs->recordSize * cursorCount, unsigned char);
+		runs->heap = xMalloc (cursorCount, unsigned int);
+		for (unsigned int i = 0; i < runs->count; i++)
+			runs->cursors [i].mio = runs->runs [i].mio;
+	}
+
+	/* The records in memory are the last run. */
+	runs->records = records;
+	runs->recordCount = count;
+
+	runs->heapCount = 0;
+	for (unsigned int i = 0; i < cursorCount; i++)
+	{
+		runs->cursors [i].next = 0;
+		if (runs->cursors [i].mio)
+			mio_rewind (runs->cursors [i].mio);
+		if (readCursor (runs, i))
+		{
+			runs->heap [runs->heapCount] = i;
+			siftUp (runs, runs->heapCount++);
+		}
+	}
+}
+
+extern bool sortedRunsNext (sortedRuns *runs, void *record)
+{
+	unsigned int top;
+
+	if (runs->heapCount == 0)
+		return false;
+
+	top = runs->heap [0];
+	memcpy (record, currentOf (runs, top), runs->recordSize);
+	if (!readCursor (runs, top))
+		runs->heap [0] = runs->heap [--runs->heapCount];
+	siftDown (runs, 0);
+	return true;
+}
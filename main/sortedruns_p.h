@@ -0,0 +1,42 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Sorting fixed size records in bounded memory with sorted runs
+*/
+#ifndef CTAGS_MAIN_SORTEDRUNS_PRIVATE_H
+#define CTAGS_MAIN_SORTEDRUNS_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sSortedRuns sortedRuns;
+typedef int (* sortedRunsCompareFunc) (const void *, const void *);
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern sortedRuns *sortedRunsNew (size_t recordSize, sortedRunsCompareFunc compare);
+extern void sortedRunsDelete (sortedRuns *runs);
+
+extern unsigned int sortedRunsCount (const sortedRuns *runs);
+
+/* Spill COUNT sorted RECORDS to a temporary file as a sorted run.
+ * RECORDS can be reused after this. */
+extern void sortedRunsSpill (sortedRuns *runs, const void *records, size_t count);
+
+/* Start merging the sorted runs and COUNT sorted RECORDS in memory, and
+ * take the records in order with sortedRunsNext (). RECORDS must be kept
+ * while merging. Calling this again restarts the merge from the first
+ * record. */
+extern void sortedRunsMerge (sortedRuns *runs, const void *records, size_t count);
+extern bool sortedRunsNext (sortedRuns *runs, void *record);
+
+#endif	/* CTAGS_MAIN_SORTEDRUNS_PRIVATE_H */
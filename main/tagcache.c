@@ -0,0 +1,285 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Cache of tags emitted for input files (--cache-dir)
+*
+*   The output for an input file is stored to a file in the cache
+*   directory. The name of the cache file is made from a hash value of
+*   the contents of the input file, the name of the input file, the
+*   parser, and the options processed so far. When ctags finds a cache
+*   file for an input file, ctags copies the contents of the cache file
+*   to the tag file instead of running the parser.
+*
+*   A cache file starts with a header line:
+*
+*     !_CTAGS_CACHE<TAB>version<TAB>key<TAB>number-of-tags<TAB>length<LF>
+*
+*   and the output of the writer, "length" bytes, follows the header.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ctags.h"
+#include "debug.h"
+#include "entry_p.h"
+#include "options_p.h"
+#include "parse.h"
+#include "ptag_p.h"
+#include "refs_p.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "tagcache_p.h"
+
+/*
+*   MACROS
+*/
+#define TAG_CACHE_MAGIC   "!_CTAGS_CACHE"
+#define TAG_CACHE_VERSION 1
+
+/* FNV-1a */
+#define HASH_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define HASH_PRIME        0x100000001b3ULL
+
+#define READ_BUFFER_SIZE  (64 * 1024)
+
+/*
+*   DATA DEFINITIONS
+*/
+static uint64_t OptionFingerprint = HASH_OFFSET_BASIS;
+
+/* Options not changing the tags emitted for an input file.
+ * The location of the tag file is taken into the key separately. */
+static const char *const IgnoredLongOptions [] = {
+	"cache-dir", "recurse", "totals", "trigram-index", "verbose",
+};
+static const char IgnoredShortOptions [] = "fLoRV";
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static uint64_t hashBytes (uint64_t h, const void *data, size_t length)
+{
+	const unsigned char *p = data;
+	const unsigned char *const end = p + length;
+
+	while (p < end)
+	{
+		h ^= *p++;
+		h *= HASH_PRIME;
+	}
+	return h;
+}
+
+static uint64_t hashString (uint64_t h, const char *const s)
+{
+	/* The terminator is included to separate strings. */
+	if (s == NULL)
+		return hashBytes (h, "", 1);
+	return hashBytes (h, s, strlen (s) + 1);
+}
+
+static bool isIgnoredOption (bool longOption, const char *const option)
+{
+	if (!longOption)
+		return (option[0] != '\0' && option[1] == '\0'
+				&& strchr (IgnoredShortOptions, option[0]) != NULL);
+
+	for (size_t i = 0; i < ARRAY_SIZE (IgnoredLongOptions); i++)
+	{
+		if (strcmp (option, IgnoredLongOptions[i]) == 0)
+			return true;
+	}
+	return false;
+}
+
+extern void updateTagCacheFingerprint (bool longOption,
+									   const char *const option, const char *const parameter)
+{
+	if (isIgnoredOption (longOption, option))
+		return;
+
+	OptionFingerprint = hashString (OptionFingerprint, longOption? "--": "-");
+	OptionFingerprint = hashString (OptionFingerprint, option);
+	OptionFingerprint = hashString (OptionFingerprint, parameter);
+}
+
+extern bool isTagCacheEnabled (void)
+{
+	if (Option.cacheDir == NULL
+		|| Option.interactive
+		|| Option.printLanguage
+		/* Reference tags don't go to the tag file. */
+		|| isReferenceOutputEnabled ())
+		return false;
+
+	/* Parser specific pseudo tags are emitted when a parser runs
+	 * the first time. Replaying cached tags cannot reproduce them. */
+	for (int i = 0; i < PTAG_COUNT; i++)
+	{
+		if (isPtagParserSpecific (i) && isPtagEnabled (i))
+			return false;
+	}
+
+	return true;
+}
+
+static bool hashFileContents (uint64_t *h, const char *const fileName, MIO *mio)
+{
+	if (mio)
+	{
+		size_t size;
+		unsigned char *data = mio_memory_get_data (mio, &size);
+
+		if (data)
+		{
+			*h = hashBytes (*h, data, size);
+			return true;
+		}
+	}
+
+	FILE *fp = fopen (fileName, "rb");
+	if (fp == NULL)
+		return false;
+
+	unsigned char *buf = eMalloc (READ_BUFFER_SIZE);
+	size_t n;
+	while ((n = fread (buf, 1, READ_BUFFER_SIZE, fp)) > 0)
+		*h = hashBytes (*h, buf, n);
+
+	bool r = !ferror (fp);
+	eFree (buf);
+	fclose (fp);
+	return r;
+}
+
+extern bool makeTagCacheKey (const char *const fileName, langType language,
+							 MIO *mio, tagCacheKey *key)
+{
+	uint64_t h = OptionFingerprint;
+
+	h = hashString (h, PROGRAM_VERSION);
+	h = hashString (h, ctags_repoinfo);
+	h = hashString (h, getLanguageName (language));
+	h = hashString (h, fileName);
+	/* Input file names in the output are relative to them. */
+	h = hashString (h, CurrentDirectory);
+	h = hashString (h, getTagFileDirectory ());
+
+	if (!hashFileContents (&h, fileName, mio))
+		return false;
+
+	key->hash = h;
+	return true;
+}
+
+static char *makeCacheFileName (const tagCacheKey *key)
+{
+	char leaf [sizeof ("0123456789abcdef.ctc")];
+
+	snprintf (leaf, sizeof (leaf), "%016llx.ctc", (unsigned long long)key->hash);
+	return combinePathAndFile (Option.cacheDir, leaf);
+}
+
+static void makeHeaderPrefix (char *buf, size_t size, const tagCacheKey *key)
+{
+	snprintf (buf, size, "%s\t%d\t%016llx\t",
+			  TAG_CACHE_MAGIC, TAG_CACHE_VERSION,
+			  (unsigned long long)key->hash);
+}
+
+extern bool replayTagCache (const tagCacheKey *key)
+{
+	char *cacheFileName = makeCacheFileName (key);
+	FILE *fp = fopen (cacheFileName, "rb");
+	eFree (cacheFileName);
+	if (fp == NULL)
+		return false;
+
+	char header [128];
+	char expected [128];
+	unsigned long numTags;
+	unsigned long length;
+	unsigned char *data = NULL;
+	char *p;
+	bool r = false;
+
+	if (fgets (header, sizeof (header), fp) == NULL)
+		goto out;
+
+	makeHeaderPrefix (expected, sizeof (expected), key);
+	if (strncmp (header, expected, strlen (expected)) != 0)
+		goto out;
+
+	p = header + strlen (expected);
+	numTags = strtoul (p, &p, 10);
+	if (*p != '\t')
+		goto out;
+	length = strtoul (p + 1, &p, 10);
+	if (*p != '\n')
+		goto out;
+
+	/* A cache file being written by another process is shorter than
+	 * the length in the header. */
+	data = eMalloc (length? length: 1);
+	if (fread (data, 1, length, fp) != length
+		|| fgetc (fp) != EOF)
+		goto out;
+
+	appendToTagFile (data, length);
+	setNumTagsAdded (numTagsAdded () + numTags);
+	r = true;
+
+ out:
+	if (data)
+		eFree (data);
+	fclose (fp);
+	return r;
+}
+
+extern void storeTagCache (const tagCacheKey *key,
+						   const unsigned char *data, size_t length,
+						   unsigned long numTags)
+{
+	char *cacheFileName = makeCacheFileName (key);
+	char *tempName = NULL;
+	FILE *fp;
+	char header [128];
+	bool r;
+
+	/* Write to a temporary file and rename it so that another ctags
+	 * process never reads a partially written cache file. */
+	fp = openFileForReplacing (cacheFileName, &tempName);
+	if (fp == NULL)
+	{
+		error (WARNING | PERROR, "cannot open cache file %s", cacheFileName);
+		eFree (cacheFileName);
+		return;
+	}
+
+	makeHeaderPrefix (header, sizeof (header), key);
+	r = (fprintf (fp, "%s%lu\t%lu\n", header, numTags, (unsigned long)length) >= 0
+		 && fwrite (data, 1, length, fp) == length);
+	if (fclose (fp) == EOF)
+		r = false;
+	if (!r)
+	{
+		error (WARNING | PERROR, "failed to write cache file %s", cacheFileName);
+		remove (tempName);
+	}
+	else if (!replaceFile (tempName, cacheFileName))
+		error (WARNING | PERROR, "cannot rename cache file %s", cacheFileName);
+
+	eFree (tempName);
+	eFree (cacheFileName);
+}
@@ -0,0 +1,54 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Cache of tags emitted for input files (--cache-dir)
+*/
+#ifndef CTAGS_MAIN_TAGCACHE_PRIVATE_H
+#define CTAGS_MAIN_TAGCACHE_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdint.h>
+
+#include "mio.h"
+#include "types.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sTagCacheKey {
+	uint64_t hash;
+} tagCacheKey;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* Options affecting the output must be recorded with this function
+ * when they are processed. */
+extern void updateTagCacheFingerprint (bool longOption,
+									   const char *const option, const char *const parameter);
+
+extern bool isTagCacheEnabled (void);
+
+/* Make a key from the contents of the input file, the option
+ * fingerprint, and the other things making the output different.
+ * If MIO is NULL, the file is read with FILENAME. */
+extern bool makeTagCacheKey (const char *const fileName, langType language,
+							 MIO *mio, tagCacheKey *key);
+
+/* Write the cached tags for KEY to the tag file. Return false if
+ * no tag is cached for KEY. */
+extern bool replayTagCache (const tagCacheKey *key);
+
+extern void storeTagCache (const tagCacheKey *key,
+						   const unsigned char *data, size_t length,
+						   unsigned long numTags);
+
+#endif	/* CTAGS_MAIN_TAGCACHE_PRIVATE_H */
@@ -0,0 +1,372 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Trigram index of tag names (--trigram-index)
+*
+*   The index lets tools find the tags having a given substring in their
+*   names without reading the whole tag file. It is written to
+*   TAGFILE.tri after the tag file is closed and sorted, and read by
+*   libreadtags. All integers are little endian.
+*
+*     header:   "CTAGSTRI", version (4 bytes), number of trigrams (4 bytes),
+*               size of the tag file (8 bytes), mtime of the tag file in
+*               seconds (8 bytes) and its nanoseconds (4 bytes), inode
+*               number of the tag file (8 bytes)
+*     table:    for each trigram in ascending order, the trigram (4 bytes),
+*               the number of tag lines (4 bytes), and the offset of the
+*               posting list in the index (8 bytes)
+*     postings: for each trigram, the file positions of the tag lines having
+*               the trigram in their names, in ascending order, encoded as
+*               LEB128 deltas
+*
+*   A trigram is three bytes of a tag name with ASCII letters downcased,
+*   packed as b0 << 16 | b1 << 8 | b2. Pseudo tags are not indexed.
+*
+*   A reader uses the index only if the size, the mtime and the inode
+*   number recorded in the header are the ones of the tag file. The
+*   nanoseconds and the inode number tell a tag file rewritten with the
+*   same size in the same second, as an editor retagging on save does.
+*   They are 0 on the platforms not having them.
+*
+*   The keys of the postings are collected in memory up to
+*   TRIGRAM_MEMORY_LIMIT bytes. Then they are sorted and spilled to a
+*   temporary file as a sorted run, and the runs are merged at the end.
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+
+#include "debug.h"
+#include "routines.h"
+#include "routines_p.h"
+#include "sortedruns_p.h"
+#include "trigram_p.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define TRIGRAM_INDEX_MAGIC   "CTAGSTRI"
+#define TRIGRAM_INDEX_VERSION 2
+#define TRIGRAM_INDEX_SUFFIX  ".tri"
+#define HEADER_SIZE           44
+#define TABLE_ENTRY_SIZE      16
+
+/* A key is a trigram and a file position packed into 64 bits. Sorting
+ * keys groups file positions by trigram. */
+#define POSITION_BITS         40
+#define POSITION_MASK         ((UINT64_C(1) << POSITION_BITS) - 1)
+
+#define READ_BUFFER_SIZE      (64 * 1024)
+
+#ifndef TRIGRAM_MEMORY_LIMIT
+#define TRIGRAM_MEMORY_LIMIT  (64 * 1024 * 1024)
+#endif
+#define MAX_KEYS_IN_MEMORY    (TRIGRAM_MEMORY_LIMIT / sizeof (uint64_t))
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sKeyArray {
+	uint64_t *keys;
+	size_t count;
+	size_t size;
+	sortedRuns *runs;
+} keyArray;
+
+/* A cursor takes the keys of the sorted runs in order, skipping the
+ * duplicated keys of the runs. */
+typedef struct sKeyCursor {
+	keyArray *a;
+	uint64_t key;
+	bool more;
+} keyCursor;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+static int compareKeys (const void *a, const void *b)
+{
+	const uint64_t ka = *(const uint64_t *)a;
+	const uint64_t kb = *(const uint64_t *)b;
+
+	return (ka < kb)? -1: (ka > kb);
+}
+
+/* Remove the duplicated keys made from a name having the same
+ * trigram twice or more. KEYS must be sorted. */
+static size_t uniqKeys (uint64_t *keys, size_t count)
+{
+	size_t n = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (n == 0 || keys [n - 1] != keys [i])
+			keys [n++] = keys [i];
+	}
+	return n;
+}
+
+static void sortKeys (keyArray *const a)
+{
+	qsort (a->keys, a->count, sizeof (a->keys [0]), compareKeys);
+	a->count = uniqKeys (a->keys, a->count);
+}
+
+static void addKey (keyArray *const a, uint64_t key)
+{
+	if (a->count == MAX_KEYS_IN_MEMORY)
+	{
+		sortKeys (a);
+		sortedRunsSpill (a->runs, a->keys, a->count);
+		a->count = 0;
+	}
+	if (a->count == a->size)
+	{
+		a->size = a->size? a->size * 2: 1024;
+		if (a->size > MAX_KEYS_IN_MEMORY)
+			a->size = MAX_KEYS_IN_MEMORY;
+		a->keys = xRealloc (a->keys, a->size, uint64_t);
+	}
+	a->keys [a->count++] = key;
+}
+
+static uint64_t downcase (unsigned char c)
+{
+	return (c >= 'A' && c <= 'Z')? c - 'A' + 'a': c;
+}
+
+static void addTrigrams (keyArray *const a, const unsigned char *name,
+						 size_t length, uint64_t position)
+{
+	for (size_t i = 0; i + 3 <= length; i++)
+	{
+		uint64_t trigram = (downcase (name [i]) << 16)
+			| (downcase (name [i + 1]) << 8)
+			| downcase (name [i + 2]);
+		addKey (a, (trigram << POSITION_BITS) | position);
+	}
+}
+
+static void addName (keyArray *const a, vString *const name, uint64_t position)
+{
+	const unsigned char *s = (unsigned char *) vStringValue (name);
+	const size_t length = vStringLength (name);
+
+	/* Skip pseudo tags. */
+	if (length >= 2 && s [0] == '!' && s [1] == '_')
+		return;
+
+	addTrigrams (a, s, length, position);
+}
+
+/* Collect the keys for all the tag lines in FP. */
+static bool collectKeys (FILE *fp, keyArray *const a)
+{
+	unsigned char *buf = xMalloc (READ_BUFFER_SIZE, unsigned char);
+	vString *name = vStringNew ();
+	uint64_t position = 0;
+	uint64_t lineStart = 0;
+	bool inName = true;
+	bool r = true;
+	size_t n;
+
+	while ((n = fread (buf, 1, READ_BUFFER_SIZE, fp)) > 0)
+	{
+		for (size_t i = 0; i < n; i++, position++)
+		{
+			const unsigned char c = buf [i];
+
+			if (c == '\n')
+			{
+				addName (a, name, lineStart);
+				vStringClear (name);
+				lineStart = position + 1;
+				inName = true;
+			}
+			else if (!inName)
+				continue;
+			else if (c == '\t' || c == '\r')
+				inName = false;
+			else
+				vStringPut (name, c);
+		}
+
+		if (position > POSITION_MASK)
+		{
+			error (WARNING, "the tag file is too large for the trigram index");
+			r = false;
+			break;
+		}
+	}
+
+	/* The last line without a newline */
+	if (r)
+		addName (a, name, lineStart);
+
+	if (ferror (fp))
+		r = false;
+
+	vStringDelete (name);
+	eFree (buf);
+	return r;
+}
+
+static uint64_t trigramOf (uint64_t key)
+{
+	return key >> POSITION_BITS;
+}
+
+static uint64_t positionOf (uint64_t key)
+{
+	return key & POSITION_MASK;
+}
+
+static void nextKey (keyCursor *const c, bool first)
+{
+	const uint64_t last = c->key;
+
+	while ((c->more = sortedRunsNext (c->a->runs, &c->key)))
+	{
+		if (first || c->key != last)
+			return;
+	}
+}
+
+static void startKeys (keyCursor *const c, keyArray *const a)
+{
+	c->a = a;
+	c->key = 0;
+	sortedRunsMerge (a->runs, a->keys, a->count);
+	nextKey (c, true);
+}
+
+/* Take the positions having the trigram of the current key, and return
+ * the number of them. The size of their LEB128 deltas is added to SIZE,
+ * and they are written to FP if it is not NULL. */
+static uint32_t nextPostings (keyCursor *const c, FILE *fp, uint64_t *size)
+{
+	const uint64_t trigram = trigramOf (c->key);
+	uint64_t last = 0;
+	uint32_t count = 0;
+
+	do
+	{
+		*size += writeLEB128 (fp, positionOf (c->key) - last);
+		last = positionOf (c->key);
+		count++;
+		nextKey (c, false);
+	} while (c->more && trigramOf (c->key) == trigram);
+
+	return count;
+}
+
+static uint64_t mtimeNsecOf (const struct stat *const status)
+{
+#if defined(HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC)
+	return status->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC_TV_NSEC)
+	return status->st_mtimespec.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+static void writeIndex (FILE *fp, keyArray *const a,
+						const struct stat *const tagFileStatus)
+{
+	keyCursor c;
+	uint32_t trigrams = 0;
+	uint64_t offset;
+	uint64_t size = 0;
+
+	for (startKeys (&c, a); c.more; trigrams++)
+		nextPostings (&c, NULL, &size);
+
+	fwrite (TRIGRAM_INDEX_MAGIC, 1, strlen (TRIGRAM_INDEX_MAGIC), fp);
+	writeUintLE (fp, TRIGRAM_INDEX_VERSION, 4);
+	writeUintLE (fp, trigrams, 4);
+	writeUintLE (fp, (uint64_t) tagFileStatus->st_size, 8);
+	writeUintLE (fp, (uint64_t) tagFileStatus->st_mtime, 8);
+	writeUintLE (fp, mtimeNsecOf (tagFileStatus), 4);
+	writeUintLE (fp, (uint64_t) tagFileStatus->st_ino, 8);
+
+	offset = HEADER_SIZE + (uint64_t) trigrams * TABLE_ENTRY_SIZE;
+	for (startKeys (&c, a); c.more; offset += size)
+	{
+		const uint64_t trigram = trigramOf (c.key);
+		uint32_t count;
+
+		size = 0;
+		count = nextPostings (&c, NULL, &size);
+		writeUintLE (fp, trigram, 4);
+		writeUintLE (fp, count, 4);
+		writeUintLE (fp, offset, 8);
+	}
+
+	for (startKeys (&c, a); c.more;)
+		nextPostings (&c, fp, &size);
+}
+
+extern void writeTrigramIndex (const char *const tagFileName)
+{
+	struct stat status;
+	keyArray a = { .keys = NULL, .count = 0, .size = 0, .runs = NULL };
+	vString *indexFileName;
+	FILE *fp;
+	bool r;
+
+	fp = fopen (tagFileName, "rb");
+	if (fp == NULL)
+	{
+		error (WARNING | PERROR, "cannot open tag file %s for the trigram index", tagFileName);
+		return;
+	}
+	a.runs = sortedRunsNew (sizeof (a.keys [0]), compareKeys);
+	r = collectKeys (fp, &a);
+	fclose (fp);
+	if (!r || stat (tagFileName, &status) != 0)
+		goto out;
+
+	sortKeys (&a);
+
+	indexFileName = vStringNewInit (tagFileName);
+	vStringCatS (indexFileName, TRIGRAM_INDEX_SUFFIX);
+	fp = fopen (vStringValue (indexFileName), "wb");
+	if (fp == NULL)
+		error (WARNING | PERROR, "cannot open trigram index file %s",
+			   vStringValue (indexFileName));
+	else
+	{
+		writeIndex (fp, &a, &status);
+		r = !ferror (fp);
+		if (fclose (fp) == EOF)
+			r = false;
+		if (!r)
+		{
+			error (WARNING | PERROR, "failed to write trigram index file %s",
+				   vStringValue (indexFileName));
+			remove (vStringValue (indexFileName));
+		}
+	}
+	vStringDelete (indexFileName);
+
+ out:
+	sortedRunsDelete (a.runs);
+	if (a.keys)
+		eFree (a.keys);
+}
@@ -0,0 +1,25 @@
+/*
+*   Copyright (c) 2026, Universal Ctags team
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License version 2 or (at your option) any later version.
+*
+*   Trigram index of tag names (--trigram-index)
+*/
+#ifndef CTAGS_MAIN_TRIGRAM_PRIVATE_H
+#define CTAGS_MAIN_TRIGRAM_PRIVATE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+
+/* Write the trigram index of the tag names in TAGFILENAME to
+ * TAGFILENAME.tri. */
+extern void writeTrigramIndex (const char *const tagFileName);
+
+#endif	/* CTAGS_MAIN_TRIGRAM_PRIVATE_H */
@@ -24,12 +24,19 @@
 /*
 *   DATA DEFINITIONS
 */
+/* The initial buffer is allocated together with the vString itself,
+ * right after it, so a short string costs one allocation. */
 static const size_t vStringInitialSize = 32;
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
+static bool isInlineBuffer (const vString *const string)
+{
+	return string->buffer == (char *) (string + 1);
+}
+
 /*
 *   External interface
 */
@@ -43,8 +50,15 @@ extern void vStringResize (vString *const string, const size_t newSize)
 
 	if (size > string->size)
 	{
+		if (isInlineBuffer (string))
+		{
+			char *buffer = xMalloc (size, char);
+			memcpy (buffer, string->buffer, string->size);
+			string->buffer = buffer;
+		}
+		else
+			string->buffer = xRealloc (string->buffer, size, char);
 		string->size = size;
-		string->buffer = xRealloc (string->buffer, size, char);
 	}
 }
 
@@ -61,7 +75,7 @@ extern void vStringDelete (vString *const string)
 {
 	if (string != NULL)
 	{
-		if (string->buffer != NULL)
+		if (string->buffer != NULL && !isInlineBuffer (string))
 			eFree (string->buffer);
 		eFree (string);
 	}
@@ -69,11 +83,11 @@ extern void vStringDelete (vString *const string)
 
 extern vString *vStringNew (void)
 {
-	vString *const string = xMalloc (1, vString);
+	vString *const string = (vString *) xMalloc (sizeof (vString) + vStringInitialSize, char);
 
 	string->length = 0;
 	string->size   = vStringInitialSize;
-	string->buffer = xMalloc (string->size, char);
+	string->buffer = (char *) (string + 1);
 
 	vStringClear (string);
 
@@ -83,7 +97,7 @@ extern vString *vStringNew (void)
 extern vString *vStringNewCopy (const vString *const string)
 {
 	vString *vs = vStringNew ();
-	vStringCatS (vs, string->buffer);
+	vStringCat (vs, string);
 	return vs;
 }
 
@@ -109,7 +123,7 @@ static void stringCat (
 
 	memcpy (string->buffer + string->length, s, length);
 	string->length += length;
-	vStringPut (string, '\0');
+	string->buffer [string->length] = '\0';
 }
 
 extern void vStringNCat (
@@ -124,9 +138,12 @@ extern void vStringNCat (
 extern void vStringNCatS (
 		vString *const string, const char *const s, const size_t length)
 {
-	size_t len = strlen (s);
+	/* S can be much longer than LENGTH; don't scan all of it. */
+	size_t len = 0;
+
+	while (len < length && s [len] != '\0')
+		len++;
 
-	len = len < length ? len : length;
 	stringCat (string, s, len);
 }
 
@@ -271,7 +288,10 @@ extern char    *vStringDeleteUnwrap       (vString *const string)
 
 	if (string != NULL)
 	{
-		buffer = string->buffer;
+		if (isInlineBuffer (string))
+			buffer = vStringStrdup (string);
+		else
+			buffer = string->buffer;
 		string->buffer = NULL;
 
 		string->size = 0;
@@ -301,6 +321,11 @@ static char valueToXDigit (int v)
 		return '0' + v;
 }
 
+static bool isEscapedChar (int c)
+{
+	return (c > 0x00 && c <= 0x1F) || c == 0x7F || c == '\\';
+}
+
 extern void vStringCatSWithEscaping (vString* b, const char *s)
 {
 	for(; *s; s++)
@@ -308,7 +333,7 @@ extern void vStringCatSWithEscaping (vString* b, const char *s)
 		int c = *s;
 
 		/* escape control characters (incl. \t) */
-		if ((c > 0x00 && c <= 0x1F) || c == 0x7F || c == '\\')
+		if (isEscapedChar (c))
 		{
 			vStringPut (b, '\\');
 
@@ -337,8 +362,18 @@ extern void vStringCatSWithEscaping (vString* b, const char *s)
 				vStringPut (b, valueToXDigit (c & 0x0F));
 				continue;
 			}
+			vStringPut (b, c);
+		}
+		else
+		{
+			/* Copy the run of characters needing no escape at once. */
+			const char *p = s + 1;
+
+			while (*p && !isEscapedChar (*p))
+				p++;
+			stringCat (b, s, p - s);
+			s = p - 1;
 		}
-		vStringPut (b, c);
 	}
 }
 
@@ -357,9 +392,12 @@ extern void vStringCatSWithEscapingAsPattern (vString *output, const char* input
 			vStringPut(output, '/');
 			break;
 		default:
-			vStringPut(output, *input);
-			break;
-
+		{
+			size_t n = strcspn (input, "\\/");
+			stringCat (output, input, n);
+			input += n;
+			continue;
+		}
 		}
 		input++;
 	}
@@ -20,12 +20,17 @@
 #include "read.h"
 #include "routines.h"
 #include "routines_p.h"
+#include "trashbox.h"
 #include "vstring.h"
 #include "writer_p.h"
 
 
 #define ETAGS_FILE  "TAGS"
 
+/* The section for an input file is built on memory. If it grows
+ * larger than this, the section is moved to a temporary file. */
+#define ETAGS_SECTION_MEMORY_LIMIT (1024 * 1024)
+
 
 static int writeEtagsEntry  (tagWriter *writer, MIO * mio, const tagEntryInfo *const tag,
 							 void *clientData CTAGS_ATTR_UNUSED);
@@ -45,51 +50,82 @@ tagWriter etagsWriter = {
 };
 
 struct sEtags {
-	char *name;
-	MIO *mio;
+	char *name;					/* temporary file; NULL while mio is memory */
+	MIO *mio;					/* the section being built */
+	MIO *memory;				/* reused for all input files */
 	size_t byteCount;
 	vString *vLine;
 };
 
 
 
+/* mio_unref () returns int; a trash box destroys with void (*)(void *). */
+static void unrefEtagsMemory (void *mio)
+{
+	mio_unref (mio);
+}
+
 static void *beginEtagsFile (tagWriter *writer CTAGS_ATTR_UNUSED, MIO *mio CTAGS_ATTR_UNUSED,
 							 void *clientData CTAGS_ATTR_UNUSED)
 {
-	static struct sEtags etags = { NULL, NULL, 0, NULL };
+	static struct sEtags etags = { NULL, NULL, NULL, 0, NULL };
 
-	etags.mio = tempFile ("w+b", &etags.name);
+	if (etags.memory == NULL)
+	{
+		etags.memory = mio_new_memory (NULL, 0, eRealloc, eFreeNoNullCheck);
+		DEFAULT_TRASH_BOX (etags.memory, unrefEtagsMemory);
+		etags.vLine = vStringNew ();
+		DEFAULT_TRASH_BOX (etags.vLine, vStringDelete);
+	}
+
+	mio_rewind (etags.memory);
+	etags.mio = etags.memory;
 	etags.byteCount = 0;
-	etags.vLine = vStringNew ();
 	return &etags;
 }
 
+static void spillEtagsSection (struct sEtags *etags)
+{
+	unsigned char *data = mio_memory_get_data (etags->memory, NULL);
+
+	etags->mio = tempFile ("w+b", &etags->name);
+	mio_write (etags->mio, data, 1, etags->byteCount);
+	abort_if_ferror (etags->mio);
+}
+
 static bool endEtagsFile (tagWriter *writer,
 						  MIO *mainfp, const char *filename,
 						  void *clientData CTAGS_ATTR_UNUSED)
 {
-	const char *line;
 	struct sEtags *etags = writer->private;
 
 	mio_printf (mainfp, "\f\n%s,%ld\n", filename, (long) etags->byteCount);
 	setNumTagsAdded (numTagsAdded () + 1);
 	abort_if_ferror (mainfp);
 
-	if (etags->mio != NULL)
+	if (etags->mio == etags->memory)
 	{
-		mio_rewind (etags->mio);
+		unsigned char *data = mio_memory_get_data (etags->memory, NULL);
 
-		while ((line = readLineRaw (etags->vLine, etags->mio)) != NULL)
-			mio_puts (mainfp, line);
+		if (etags->byteCount > 0)
+			mio_write (mainfp, data, 1, etags->byteCount);
+	}
+	else if (etags->mio != NULL)
+	{
+		unsigned char buf [BUFSIZ];
+		size_t n;
+
+		mio_rewind (etags->mio);
+		while ((n = mio_read (etags->mio, buf, 1, sizeof (buf))) > 0)
+			mio_write (mainfp, buf, 1, n);
 
-		vStringDelete (etags->vLine);
 		mio_unref (etags->mio);
 		remove (etags->name);
 		eFree (etags->name);
-		etags->vLine = NULL;
-		etags->mio = NULL;
 		etags->name = NULL;
 	}
+	etags->mio = NULL;
+	abort_if_ferror (mainfp);
 	return false;
 }
 
@@ -198,5 +234,9 @@ static int writeEtagsEntry (tagWriter *writer,
 	}
 	etags->byteCount += length;
 
+	if (etags->mio == etags->memory
+		&& etags->byteCount > ETAGS_SECTION_MEMORY_LIMIT)
+		spillEtagsSection (etags);
+
 	return length;
 }
@@ -40,6 +40,11 @@ extern void setTagWriter (writerType wtype, tagWriter *customWriter)
 	writer->type = wtype;
 }
 
+extern writerType getTagWriterType (void)
+{
+	return writer->type;
+}
+
 extern void writerSetup (MIO *mio, void *clientData)
 {
 	writer->clientData = clientData;
@@ -71,6 +71,7 @@ struct sTagWriter {
 
 /* customWriter is used only if otype is WRITER_CUSTOM */
 extern void setTagWriter (writerType otype, tagWriter *customWriter);
+extern writerType getTagWriterType (void);
 extern void writerSetup  (MIO *mio, void *clientData);
 extern bool writerTeardown (MIO *mio, const char *filename);
 
@@ -2924,6 +2924,7 @@ static bool generate(context_t *ctx) {
             stream,
             "struct %s_context_tag {\n"
             "    int pos;\n"
+            "    int buffer_start_position; /* input offset of buffer.buf[0] */\n"
             "    pcc_char_array_t buffer;\n"
             "    pcc_lr_table_t lrtable;\n"
             "    pcc_lr_stack_t lrstack;\n"
@@ -3468,6 +3469,7 @@ static bool generate(context_t *ctx) {
         );
         fputs(
             "    ctx->pos = 0;\n"
+            "    ctx->buffer_start_position = 0;\n"
             "    pcc_char_array__init(auxil, &ctx->buffer, PCC_BUFFERSIZE);\n"
             "    pcc_lr_table__init(auxil, &ctx->lrtable, PCC_BUFFERSIZE);\n"
             "    pcc_lr_stack__init(auxil, &ctx->lrstack, PCC_ARRAYSIZE);\n"
@@ -3521,6 +3523,7 @@ static bool generate(context_t *ctx) {
             "    memmove(ctx->buffer.buf, ctx->buffer.buf + ctx->pos, ctx->buffer.len - ctx->pos);\n"
             "    ctx->buffer.len -= ctx->pos;\n"
             "    pcc_lr_table__shift(ctx->auxil, &ctx->lrtable, ctx->pos);\n"
+            "    ctx->buffer_start_position += ctx->pos;\n"
             "    ctx->pos = 0;\n"
             "}\n"
             "\n",
@@ -3715,8 +3718,8 @@ static bool generate(context_t *ctx) {
                     }
                     fputs(
                         "#define _0 pcc_get_capture_string(__pcc_ctx, &__pcc_in->data.leaf.capt0)\n"
-                        "#define _0s ((const int)__pcc_in->data.leaf.capt0.range.start)\n"
-                        "#define _0e ((const int)__pcc_in->data.leaf.capt0.range.end)\n",
+                        "#define _0s ((const int)(__pcc_ctx->buffer_start_position + __pcc_in->data.leaf.capt0.range.start))\n"
+                        "#define _0e ((const int)(__pcc_ctx->buffer_start_position + __pcc_in->data.leaf.capt0.range.end))\n",
                         stream
                     );
                     for (k = 0; k < c->len; k++) {
@@ -3729,13 +3732,13 @@ static bool generate(context_t *ctx) {
                         );
                         fprintf(
                             stream,
-                            "#define _%ds __pcc_in->data.leaf.capts.buf[%d]->range.start\n",
+                            "#define _%ds (__pcc_ctx->buffer_start_position + __pcc_in->data.leaf.capts.buf[%d]->range.start)\n",
                             c->buf[k]->data.capture.index + 1,
                             c->buf[k]->data.capture.index
                         );
                         fprintf(
                             stream,
-                            "#define _%de __pcc_in->data.leaf.capts.buf[%d]->range.end\n",
+                            "#define _%de (__pcc_ctx->buffer_start_position + __pcc_in->data.leaf.capts.buf[%d]->range.end)\n",
                             c->buf[k]->data.capture.index + 1,
                             c->buf[k]->data.capture.index
                         );
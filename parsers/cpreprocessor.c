@@ -229,6 +229,7 @@ static cppState Cpp = {
 
 static hashTable *makeMacroTable (void);
 static cppMacroInfo * saveMacro(hashTable *table, const char * macro);
+static void freezeCmdlineMacroTable (void);
 
 /*
 *   FUNCTION DEFINITIONS
@@ -341,6 +342,8 @@ static void cppInitCommon(langType clientLang,
 		doesExpandMacros && isFieldEnabled (FIELD_SIGNATURE) && isFieldEnabled (Cpp.macrodefFieldIndex)
 		? makeMacroTable ()
 		: NULL;
+
+	freezeCmdlineMacroTable ();
 }
 
 extern void cppInit (const bool state, const bool hasAtLiteralStrings,
@@ -1651,6 +1654,13 @@ static void findCppTags (void)
 
 static hashTable * cmdlineMacroTable;
 
+/* The table is filled only while processing options; it is
+ * read-only while parsing. */
+static void freezeCmdlineMacroTable (void)
+{
+	if (cmdlineMacroTable)
+		hashTableFreeze (cmdlineMacroTable);
+}
 
 static bool buildMacroInfoFromTagEntry (int corkIndex,
 										tagEntryInfo * entry,
@@ -9,6 +9,9 @@
 
 #include "general.h"
 
+#include <ctype.h>
+#include <string.h>
+
 #include "cxx_debug.h"
 #include "cxx_keyword.h"
 #include "cxx_token.h"
@@ -72,6 +75,150 @@
 // - Forward declarations might become tags
 
 
+//
+// A C input can be reparsed from a line starting a top level declaration
+// in the common coding style: the line starts with an identifier at the
+// first column, and the previous line is empty or ends a declaration.
+// A label at the first column is not a checkpoint, and neither is a line
+// in a block, in a comment, in a continued preprocessor directive, or in
+// a conditional branch the full parse may skip (#else, #elif and #if 0).
+// The state keeps them for the lines scanned:
+//
+//   bits 0-7:   depth of #if
+//   bits 8-15:  depth of the #if of the skipped branch, or 0
+//   bits 16-28: depth of braces
+//   bit 29:     in a comment
+//   bit 30:     in a directive continued with a backslash
+//
+#define CXX_CHECKPOINT_IF_MASK 0xff
+#define CXX_CHECKPOINT_SKIP_SHIFT 8
+#define CXX_CHECKPOINT_BRACE_SHIFT 16
+#define CXX_CHECKPOINT_BRACE_MASK 0x1fff
+#define CXX_CHECKPOINT_IN_COMMENT (1 << 29)
+#define CXX_CHECKPOINT_IN_DIRECTIVE (1 << 30)
+
+static void cxxCScanCheckpointState(const char * line,int * state)
+{
+	int iDepth = *state & CXX_CHECKPOINT_IF_MASK;
+	int iSkipDepth = (*state >> CXX_CHECKPOINT_SKIP_SHIFT) & CXX_CHECKPOINT_IF_MASK;
+	int iBraceDepth = (*state >> CXX_CHECKPOINT_BRACE_SHIFT) & CXX_CHECKPOINT_BRACE_MASK;
+	bool bInComment = (*state & CXX_CHECKPOINT_IN_COMMENT) != 0;
+	bool bInDirective = (*state & CXX_CHECKPOINT_IN_DIRECTIVE) != 0;
+	const char * p = line;
+	const char * e;
+
+	while(isspace((unsigned char)*p))
+		p++;
+
+	if((!bInComment) && (!bInDirective) && (*p == '#'))
+	{
+		bInDirective = true;
+
+		p++;
+		while(isspace((unsigned char)*p))
+			p++;
+
+		if(strncmp(p,"if",2) == 0)
+		{
+			if(iDepth < CXX_CHECKPOINT_IF_MASK)
+				iDepth++;
+			if((iSkipDepth == 0) && (strncmp(p,"if 0",4) == 0))
+				iSkipDepth = iDepth;
+		} else if((strncmp(p,"else",4) == 0) || (strncmp(p,"elif",4) == 0))
+		{
+			if((iSkipDepth == 0) && (iDepth > 0))
+				iSkipDepth = iDepth;
+		} else if(strncmp(p,"endif",5) == 0)
+		{
+			if(iSkipDepth == iDepth)
+				iSkipDepth = 0;
+			if(iDepth > 0)
+				iDepth--;
+		}
+	}
+
+	for(;*p;p++)
+	{
+		if(bInComment)
+		{
+			if((p[0] == '*') && (p[1] == '/'))
+			{
+				bInComment = false;
+				p++;
+			}
+		} else if((p[0] == '/') && (p[1] == '*'))
+		{
+			bInComment = true;
+			p++;
+		} else if((p[0] == '/') && (p[1] == '/'))
+		{
+			break;
+		} else if((*p == '"') || (*p == '\''))
+		{
+			char q = *p++;
+
+			while(*p && (*p != q))
+			{
+				if((*p == '\\') && p[1])
+					p++;
+				p++;
+			}
+			if(!*p)
+				break;
+		} else if(bInDirective || (iSkipDepth != 0))
+		{
+			// braces in macros and in the skipped branches are
+			// not seen by the full parse
+		} else if(*p == '{')
+		{
+			if(iBraceDepth < CXX_CHECKPOINT_BRACE_MASK)
+				iBraceDepth++;
+		} else if(*p == '}')
+		{
+			if(iBraceDepth > 0)
+				iBraceDepth--;
+		}
+	}
+
+	if(bInDirective)
+	{
+		e = line + strlen(line);
+		bInDirective = (e > line) && (e[-1] == '\\');
+	}
+
+	*state = iDepth | (iSkipDepth << CXX_CHECKPOINT_SKIP_SHIFT) |
+			(iBraceDepth << CXX_CHECKPOINT_BRACE_SHIFT) |
+			(bInComment ? CXX_CHECKPOINT_IN_COMMENT : 0) |
+			(bInDirective ? CXX_CHECKPOINT_IN_DIRECTIVE : 0);
+}
+
+static bool cxxCIsCheckpoint(const char * prevLine,const char * line,int * state)
+{
+	const char * p = line;
+	const char * e;
+
+	cxxCScanCheckpointState(prevLine,state);
+
+	if(*state & ~CXX_CHECKPOINT_IF_MASK)
+		return false;
+
+	if(!(isalpha((unsigned char)*p) || (*p == '_')))
+		return false;
+
+	while(isalnum((unsigned char)*p) || (*p == '_'))
+		p++;
+	while(isspace((unsigned char)*p))
+		p++;
+	if(*p == ':')
+		return false;
+
+	e = prevLine + strlen(prevLine);
+	while((e > prevLine) && isspace((unsigned char)e[-1]))
+		e--;
+
+	return (e == prevLine) || (((e[-1] == ';') || (e[-1] == '}')) && (*prevLine != '#'));
+}
+
 parserDefinition * CParser (void)
 {
 	static const char * const extensions [] =
@@ -94,6 +241,7 @@ parserDefinition * CParser (void)
 	def->finalize = cxxParserCleanup;
 	def->selectLanguage = selectors;
 	def->useCork = CORK_QUEUE|CORK_SYMTAB; // We use corking to block output until the end of file
+	def->isCheckpoint = cxxCIsCheckpoint;
 
 	return def;
 }
@@ -1569,6 +1569,64 @@ static void finalize (langType language CTAGS_ATTR_UNUSED, bool initialized)
 	objPoolDelete (TokenPool);
 }
 
+/* A Python input can be reparsed from a top level "def", "class" or
+ * decorator line, unless the line continues the previous one, follows
+ * a decorator, or is in a triple quoted string. STATE keeps the quote
+ * character of the triple quoted string open at the end of the lines
+ * scanned. */
+static void scanCheckpointState (const char *line, int *state)
+{
+	for (const char *p = line; *p; p++)
+	{
+		if (*state)
+		{
+			if (*p == '\\' && p[1])
+				p++;
+			else if (*p == *state && p[1] == *state && p[2] == *state)
+			{
+				*state = 0;
+				p += 2;
+			}
+		}
+		else if (*p == '#')
+			break;
+		else if (*p == '"' || *p == '\'')
+		{
+			const char q = *p;
+
+			if (p[1] == q && p[2] == q)
+			{
+				*state = q;
+				p += 2;
+				continue;
+			}
+			for (p++; *p && *p != q; p++)
+				if (*p == '\\' && p[1])
+					p++;
+			if (*p == '\0')
+				break;
+		}
+	}
+}
+
+static bool isCheckpoint (const char *prevLine, const char *line, int *state)
+{
+	const size_t prevLength = strlen (prevLine);
+
+	scanCheckpointState (prevLine, state);
+	if (*state)
+		return false;
+
+	if (! (strncmp (line, "def ", 4) == 0
+		   || strncmp (line, "class ", 6) == 0
+		   || strncmp (line, "async def ", 10) == 0
+		   || line[0] == '@'))
+		return false;
+
+	return (prevLine[0] != '@'
+			&& (prevLength == 0 || prevLine[prevLength - 1] != '\\'));
+}
+
 extern parserDefinition* PythonParser (void)
 {
 	static const char *const extensions[] = { "py", "pyx", "pxd", "pxi", "scons",
@@ -1588,5 +1646,6 @@ extern parserDefinition* PythonParser (void)
 	def->fieldCount = ARRAY_SIZE (PythonFields);
 	def->useCork = CORK_QUEUE;
 	def->requestAutomaticFQTag = true;
+	def->isCheckpoint = isCheckpoint;
 	return def;
 }
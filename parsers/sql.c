@@ -75,6 +75,7 @@ enum eKeywordId {
 	KEYWORD_check,
 	KEYWORD_comment,
 	KEYWORD_constraint,
+	KEYWORD_copy,
 	KEYWORD_create,
 	KEYWORD_cursor,
 	KEYWORD_datatype,
@@ -98,6 +99,7 @@ enum eKeywordId {
 	KEYWORD_handler,
 	KEYWORD_if,
 	KEYWORD_index,
+	KEYWORD_insert,
 	KEYWORD_internal,
 	KEYWORD_is,
 	KEYWORD_local,
@@ -255,6 +257,7 @@ static const keywordTable SqlKeywordTable [] = {
 	{ "check",							KEYWORD_check			      },
 	{ "comment",						KEYWORD_comment			      },
 	{ "constraint",						KEYWORD_constraint		      },
+	{ "copy",							KEYWORD_copy			      },
 	{ "create",							KEYWORD_create				  },
 	{ "cursor",							KEYWORD_cursor			      },
 	{ "datatype",						KEYWORD_datatype		      },
@@ -278,6 +281,7 @@ static const keywordTable SqlKeywordTable [] = {
 	{ "handler",						KEYWORD_handler			      },
 	{ "if",								KEYWORD_if				      },
 	{ "index",							KEYWORD_index			      },
+	{ "insert",							KEYWORD_insert			      },
 	{ "internal",						KEYWORD_internal		      },
 	{ "is",								KEYWORD_is				      },
 	{ "local",							KEYWORD_local			      },
@@ -365,6 +369,7 @@ static struct SqlReservedWord SqlReservedWord [SQLKEYWORD_COUNT] = {
 	[KEYWORD_check]         = {1 & 1&1&1&1 & 1&1 & 1},
 	[KEYWORD_comment]       = {0 & 0&0&0&0 & 1&1 & 1},
 	[KEYWORD_constraint]    = {1 & 1&1&1&1 & 0&1 & 1},
+	[KEYWORD_copy]          = {0 & 0&0&0&0 & 0&0 & 0},
 	[KEYWORD_create]        = {1 & 1&1&1&1 & 1&1 & 1},
 	[KEYWORD_cursor]        = {1 & 0&1&1&1 & 0&1 & 1},
 	[KEYWORD_datatype]      = {0 & 0&0&0&0 & 0&0 & 0},
@@ -388,6 +393,7 @@ static struct SqlReservedWord SqlReservedWord [SQLKEYWORD_COUNT] = {
 	[KEYWORD_handler]       = {0 & 0&0&0&0 & 0&0 & 0},
 	[KEYWORD_if]            = {1 & 0&0&0&0 & 0&1 & 1},
 	[KEYWORD_index]         = {1 & 0&0&0&0 & 1&1 & 1},
+	[KEYWORD_insert]        = {1 & 0&1&1&1 & 1&1 & 1},
 	[KEYWORD_internal]      = {1 & 0&1&1&0 & 0&0 & 0},
 	[KEYWORD_is]            = {0, SqlReservedWordPredicatorForIsOrAs},
 	[KEYWORD_local]         = {0 & 0&1&1&1 & 0&0 & 0},
@@ -622,7 +628,8 @@ static void parseIdentifier (vString *const string, const int firstChar)
 }
 
 /* Parse a PostgreSQL: dollar-quoted string
- * https://www.postgresql.org/docs/current/static/sql-syntax-lexical.html#SQL-SYNTAX-DOLLAR-QUOTING */
+ * https://www.postgresql.org/docs/current/static/sql-syntax-lexical.html#SQL-SYNTAX-DOLLAR-QUOTING
+ * If STRING is NULL, the content is skipped without being stored. */
 static tokenType parseDollarQuote (vString *const string, const int delimiter)
 {
 	unsigned int len = 0;
@@ -643,7 +650,9 @@ static tokenType parseDollarQuote (vString *const string, const int delimiter)
 
 	if (c != delimiter)
 	{
-		/* damn that's not valid, what can we do? */
+		/* damn that's not valid, what can we do? Keep the character
+		 * after "$tag", like ")" of "$1)", for the caller. */
+		ungetcToInputFile (c);
 		return TOKEN_UNDEFINED;
 	}
 
@@ -651,7 +660,10 @@ static tokenType parseDollarQuote (vString *const string, const int delimiter)
 	while ((c = getcFromInputFile ()) != EOF)
 	{
 		if (c != delimiter)
-			vStringPut (string, c);
+		{
+			if (string)
+				vStringPut (string, c);
+		}
 		else
 		{
 			char *end_p = tag;
@@ -667,7 +679,8 @@ static tokenType parseDollarQuote (vString *const string, const int delimiter)
 			else
 			{
 				ungetcToInputFile (c);
-				vStringNCatS (string, tag, (size_t) (end_p - tag));
+				if (string)
+					vStringNCatS (string, tag, (size_t) (end_p - tag));
 			}
 		}
 	}
@@ -2649,8 +2662,158 @@ static void parseComment (tokenInfo *const token)
 }
 
 
+/* Skip the data lines following "COPY ... FROM stdin;" until the line
+ * of "\.". */
+static void skipCopyData (void)
+{
+	int c = skipToCharacterInInputFile ('\n');
+
+	while (c != EOF)
+	{
+		c = getcFromInputFile ();
+		if (c == '\\' && (c = getcFromInputFile ()) == '.')
+		{
+			c = getcFromInputFile ();
+			if (c == '\r')
+				c = getcFromInputFile ();
+			if (c == '\n' || c == EOF)
+				return;
+		}
+		if (c != '\n')
+			c = skipToCharacterInInputFile ('\n');
+	}
+}
+
+/*
+ * INSERT and COPY statements carry the bulk data of database dumps but
+ * no tags. Instead of reading tokens, their text is skipped with a scanner
+ * of characters until the command terminator. Quoted strings ('' is an
+ * escaped quote), dollar-quoted strings and comments are skipped as
+ * readToken() does. Terminators other than ; are accepted only outside
+ * parentheses, so that the values in them are not taken as terminators.
+ * For COPY ... FROM stdin, the data lines after the statement are skipped
+ * too.
+ *
+ * As ; is optional in T-SQL, the skipping also ends at a keyword starting
+ * another statement outside parentheses. Then the token is left to the
+ * keyword for the caller, and true is returned.
+ */
+static bool isStatementStart (tokenInfo *const token)
+{
+	switch (token->keyword)
+	{
+		case KEYWORD_copy:
+		case KEYWORD_create:
+		case KEYWORD_declare:
+		case KEYWORD_drop:
+		case KEYWORD_insert:
+			return true;
+		default:
+			return strcasecmp (vStringValue (token->string), "alter") == 0;
+	}
+}
+
+static bool skipDataStatement (tokenInfo *const token)
+{
+	const bool copy = isKeyword (token, KEYWORD_copy);
+	bool fromStdin = false;
+	int depth = 0;
+	int c;
+
+	token->type = TOKEN_UNDEFINED;
+	token->keyword = KEYWORD_NONE;
+	vStringClear (token->string);
+
+	while (isType (token, TOKEN_UNDEFINED))
+	{
+		c = getcFromInputFile ();
+		switch (c)
+		{
+			case EOF:
+				token->type = TOKEN_EOF;
+				break;
+			case '\'':
+			case '"':
+				if (skipToCharacterInInputFile (c) == EOF)
+					token->type = TOKEN_EOF;
+				break;
+			case '$':
+				parseDollarQuote (NULL, c);
+				break;
+			case '#':
+				skipToCharacterInInputFile ('\n');
+				break;
+			case '-':
+				c = getcFromInputFile ();
+				if (c == '-')
+					skipToCharacterInInputFile ('\n');
+				else
+					ungetcToInputFile (c);
+				break;
+			case '/':
+				c = getcFromInputFile ();
+				if (c == '*')
+					skipToCharacterInInputFile2 ('*', '/');
+				else if (c == '/')
+					skipToCharacterInInputFile ('\n');
+				else
+				{
+					ungetcToInputFile (c);
+					if (depth == 0)
+						token->type = TOKEN_FORWARD_SLASH;
+				}
+				break;
+			case '(':
+				depth++;
+				break;
+			case ')':
+				if (depth > 0)
+					depth--;
+				break;
+			case ';':
+				token->type = TOKEN_SEMICOLON;
+				break;
+			case '~':
+				if (depth == 0)
+					token->type = TOKEN_TILDE;
+				break;
+			default:
+				if (depth == 0 && isIdentChar1 (c))
+				{
+					parseIdentifier (token->string, c);
+					token->keyword = lookupCaseKeyword (vStringValue (token->string), Lang_sql);
+					if (isKeyword (token, KEYWORD_go))
+						token->type = TOKEN_KEYWORD;
+					else if (isStatementStart (token))
+					{
+						token->type = isKeyword (token, KEYWORD_NONE)? TOKEN_IDENTIFIER: TOKEN_KEYWORD;
+						return true;
+					}
+					else
+					{
+						if (copy
+							&& strcasecmp (vStringValue (token->string), "stdin") == 0)
+							fromStdin = true;
+						token->keyword = KEYWORD_NONE;
+						vStringClear (token->string);
+					}
+				}
+				break;
+		}
+	}
+
+	if (fromStdin && isType (token, TOKEN_SEMICOLON))
+		skipCopyData ();
+	return false;
+}
+
 static void parseKeywords (tokenInfo *const token)
 {
+		/* A data statement without a terminator ends at the next statement. */
+		while ((isKeyword (token, KEYWORD_copy) || isKeyword (token, KEYWORD_insert))
+			   && skipDataStatement (token))
+			;
+
 		switch (token->keyword)
 		{
 			case KEYWORD_begin:			parseBlock (token, false); break;
@@ -185,10 +185,25 @@ static void runAfter (xmlXPathContext *ctx, xmlNode *root, void *user_data)
 	}
 }
 
+/* Without a subparser running its xpath engine on the tree, the input
+ * can be read without building the whole tree. */
+static bool doesSubparserRunXPathEngine (void)
+{
+	subparser *sub;
+	foreachSubparser (sub, false)
+	{
+		if (((xmlSubparser *)sub)->runXPathEngine)
+			return true;
+	}
+	return false;
+}
+
 static void
 findXmlTags (void)
 {
-	findXMLTagsFull (NULL, NULL, TABLE_MAIN, runAfter, NULL);
+	findXMLTagsFull (NULL, NULL, TABLE_MAIN,
+					 doesSubparserRunXPathEngine ()? runAfter: NULL,
+					 NULL);
 }
 
 extern parserDefinition*
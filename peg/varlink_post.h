@@ -88,6 +88,14 @@ static int makeVarlinkTag (struct parserCtx *auxil, const char *name, long offse
 {
 	tagEntryInfo e;
 	int k = peekKind (auxil);
+
+	/* Members are declared after the interface. */
+	if (!auxil->interface_seen)
+	{
+		reportError (auxil);
+		return CORK_NIL;
+	}
+
 	initTagEntry(&e, name, k);
 	e.lineNumber = getInputLineNumberForFileOffset (offset);
 	e.filePosition = getInputFilePositionForLine (e.lineNumber);
@@ -100,6 +108,7 @@ static void ctxInit (struct parserCtx *auxil)
 	auxil->kind_stack = intArrayNew ();
 	pushKind (auxil, K_INTERFACE);
 	auxil->scope_cork_index = CORK_NIL;
+	auxil->interface_seen = false;
 	auxil->found_syntax_error = false;
 }
 
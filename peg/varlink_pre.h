@@ -69,6 +69,7 @@ struct parserCtx {
 	int scope_cork_index;
 	intArray *kind_stack;
 	methodParamState mparam_state;
+	bool interface_seen;
 	bool found_syntax_error;
 };
 
@@ -50,6 +50,7 @@ MAIN_PUBLIC_HEADS =		\
 
 LIB_PRIVATE_HEADS =		\
 	main/args_p.h		\
+	main/budget_p.h		\
 	main/colprint_p.h	\
 	main/dependency_p.h	\
 	main/entry_p.h		\
@@ -57,6 +58,7 @@ LIB_PRIVATE_HEADS =		\
 	main/field_p.h		\
 	main/flags_p.h		\
 	main/fmt_p.h		\
+	main/generated_p.h	\
 	main/interactive_p.h	\
 	main/keyword_p.h	\
 	main/kind_p.h		\
@@ -69,14 +71,19 @@ LIB_PRIVATE_HEADS =		\
 	main/parse_p.h		\
 	main/parsers_p.h	\
 	main/portable-dirent_p.h\
+	main/probe_p.h		\
 	main/promise_p.h	\
 	main/ptag_p.h		\
 	main/read_p.h		\
+	main/refs_p.h		\
 	main/routines_p.h	\
 	main/sort_p.h		\
+	main/sortedruns_p.h	\
 	main/stats_p.h		\
 	main/subparser_p.h	\
+	main/tagcache_p.h	\
 	main/trashbox_p.h	\
+	main/trigram_p.h	\
 	main/writer_p.h		\
 	main/xtag_p.h		\
 	\
@@ -93,6 +100,7 @@ LIB_HEADS =			\
 
 LIB_SRCS =			\
 	main/args.c			\
+	main/budget.c			\
 	main/colprint.c			\
 	main/dependency.c		\
 	main/entry.c			\
@@ -101,6 +109,7 @@ LIB_SRCS =			\
 	main/field.c			\
 	main/flags.c			\
 	main/fmt.c			\
+	main/generated.c		\
 	main/htable.c			\
 	main/keyword.c			\
 	main/kind.c			\
@@ -120,14 +129,18 @@ LIB_SRCS =			\
 	main/ptrarray.c			\
 	main/rbtree.c			\
 	main/read.c			\
+	main/refs.c			\
 	main/routines.c			\
 	main/seccomp.c			\
 	main/selectors.c		\
 	main/sort.c			\
+	main/sortedruns.c	\
 	main/stats.c			\
 	main/strlist.c			\
+	main/tagcache.c			\
 	main/trace.c			\
 	main/trashbox.c			\
+	main/trigram.c			\
 	main/tokeninfo.c		\
 	main/unwindi.c			\
 	main/vstring.c			\